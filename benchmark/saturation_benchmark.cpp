@@ -0,0 +1,135 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   saturation_benchmark.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+// Compares time and allocated memory of pre* and post* with Trace_Type::Any and Trace_Type::None on a random PDA,
+// and the throughput of PAutomaton::accepts and BatchQuery on the pre* automaton.
+// Usage: saturation_benchmark [n_states] [n_rules] [n_labels] [seed]
+
+#include <pdaaal/Solver.h>
+#include <pdaaal/BatchQuery.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+
+static std::atomic<size_t> allocated_bytes{0};
+
+void* operator new(std::size_t size) {
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+using namespace pdaaal;
+
+TypedPDA<int> random_pda(size_t n_states, size_t n_rules, size_t n_labels, unsigned int seed) {
+    std::unordered_set<int> labels;
+    for (size_t i = 0; i < n_labels; ++i) {
+        labels.insert(static_cast<int>(i));
+    }
+    std::vector<op_t> ops{PUSH, POP, SWAP, NOOP};
+    TypedPDA<int> pda(labels);
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<size_t> state_dist(0, n_states - 1);
+    std::uniform_int_distribution<int> label_dist(0, static_cast<int>(n_labels) - 1);
+    std::uniform_int_distribution<size_t> op_dist(0, ops.size() - 1);
+    for (size_t i = 0; i < n_rules; ++i) {
+        pda.add_rule(state_dist(gen), state_dist(gen), ops[op_dist(gen)], label_dist(gen), label_dist(gen));
+    }
+    pda.add_rule(n_states - 1, n_states - 1, NOOP, 0, 0); // Make sure all states exist.
+    return pda;
+}
+
+size_t count_edges(const PAutomaton<>& automaton) {
+    size_t result = 0;
+    for (const auto& from : automaton.states()) {
+        for (const auto& [to,labels] : from->_edges) {
+            result += labels.size();
+        }
+    }
+    return result;
+}
+
+template <typename Fn>
+void measure(const std::string& name, const TypedPDA<int>& pda, Fn&& saturate) {
+    PAutomaton automaton(pda, 0, pda.encode_pre(std::vector<int>{0, 1}));
+    auto bytes_before = allocated_bytes.load();
+    auto start = std::chrono::steady_clock::now();
+    saturate(automaton);
+    auto stop = std::chrono::steady_clock::now();
+    auto bytes = allocated_bytes.load() - bytes_before;
+    std::cout << name << ": " << std::chrono::duration<double, std::milli>(stop - start).count() << " ms, "
+              << bytes / 1024 << " KiB allocated, " << count_edges(automaton) << " edges" << std::endl;
+}
+
+int main(int argc, const char** argv) {
+    size_t n_states = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    size_t n_rules = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+    size_t n_labels = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 4;
+    unsigned int seed = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 0;
+    auto pda = random_pda(n_states, n_rules, n_labels, seed);
+
+    measure("pre*  Any ", pda, [](auto& automaton) {
+        Solver::pre_star<Trace_Type::Any,void,std::less<void>,add<void>,false>(automaton); });
+    measure("pre*  None", pda, [](auto& automaton) {
+        Solver::pre_star<Trace_Type::None,void,std::less<void>,add<void>,false>(automaton); });
+    measure("post* Any ", pda, [](auto& automaton) { Solver::post_star<Trace_Type::Any>(automaton); });
+    measure("post* None", pda, [](auto& automaton) { Solver::post_star<Trace_Type::None>(automaton); });
+
+    PAutomaton automaton(pda, 0, pda.encode_pre(std::vector<int>{0, 1}));
+    Solver::pre_star(automaton);
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<size_t> state_dist(0, n_states - 1);
+    std::uniform_int_distribution<uint32_t> label_dist(0, static_cast<uint32_t>(n_labels) - 1);
+    std::uniform_int_distribution<size_t> length_dist(1, 8);
+    std::vector<std::pair<size_t,std::vector<uint32_t>>> queries(100000);
+    for (auto& [state, stack] : queries) {
+        state = state_dist(gen);
+        stack.resize(length_dist(gen));
+        for (auto& label : stack) {
+            label = label_dist(gen);
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    size_t accepted = 0;
+    for (const auto& [state, stack] : queries) {
+        accepted += automaton.accepts(state, stack) ? 1 : 0;
+    }
+    std::chrono::duration<double> accepts_time = std::chrono::steady_clock::now() - start;
+    std::cout << "accepts   : " << queries.size() / accepts_time.count() << " queries/s, " << accepted << " accepted" << std::endl;
+    BatchQuery batch(automaton);
+    for (const auto& [state, stack] : queries) {
+        batch.add(state, stack);
+    }
+    const auto& result = batch.run();
+    std::cout << "BatchQuery: " << batch.queries_per_second() << " queries/s, "
+              << std::count(result.begin(), result.end(), true) << " accepted" << std::endl;
+    return 0;
+}
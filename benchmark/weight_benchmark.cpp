@@ -0,0 +1,102 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   weight_benchmark.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+// Compares weight_less<std::array<Inner,N>> with std::lexicographical_compare, to show whether the kernel in
+// weight_simd.h pays off on this machine and compiler flags. Build with -DPDAAAL_NO_SIMD to see the scalar code in both columns.
+// (add<std::array<Inner,N>> has no kernel, since -O2 already vectorizes its element-wise loop.)
+// Usage: weight_benchmark [n_weights] [rounds] [seed]
+
+#include <pdaaal/Weight.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pdaaal;
+
+template <typename Inner, std::size_t N>
+std::vector<std::array<Inner,N>> random_weights(size_t n, unsigned int seed) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<uint32_t> dist(0, 3); // Few values, so the lexicographic compare often looks past the first lane.
+    std::vector<std::array<Inner,N>> weights(n);
+    for (auto& w : weights) {
+        for (auto& x : w) {
+            x = static_cast<Inner>(dist(gen));
+        }
+    }
+    return weights;
+}
+
+template <typename Fn>
+double time_ms(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Inner, std::size_t N>
+void measure(const std::string& name, size_t n, size_t rounds, unsigned int seed) {
+    using W = std::array<Inner,N>;
+    auto lhs = random_weights<Inner,N>(n, seed);
+    auto rhs = random_weights<Inner,N>(n, seed + 1);
+    size_t less_kernel = 0, less_scalar = 0;
+    auto less_kernel_ms = time_ms([&]() {
+        for (size_t r = 0; r < rounds; ++r) {
+            for (size_t i = 0; i < n; ++i) less_kernel += weight_less<W>()(lhs[i], rhs[(i + r) % n]) ? 1 : 0;
+        }
+    });
+    auto less_scalar_ms = time_ms([&]() {
+        for (size_t r = 0; r < rounds; ++r) {
+            for (size_t i = 0; i < n; ++i) {
+                const auto& a = lhs[i];
+                const auto& b = rhs[(i + r) % n];
+                less_scalar += std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end()) ? 1 : 0;
+            }
+        }
+    });
+    std::cout << name << ": " << less_kernel_ms << " ms (scalar " << less_scalar_ms << " ms)"
+              << (less_kernel == less_scalar ? "" : "  MISMATCH") << std::endl;
+}
+
+int main(int argc, const char** argv) {
+    size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+    size_t rounds = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+    unsigned int seed = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 0;
+#ifdef PDAAAL_SIMD_WEIGHTS
+    std::cout << "SIMD kernel enabled" << std::endl;
+#else
+    std::cout << "SIMD kernel disabled" << std::endl;
+#endif
+    measure<uint32_t,4>("uint32_t x 4", n, rounds, seed);
+    measure<uint32_t,8>("uint32_t x 8", n, rounds, seed);
+    measure<uint64_t,4>("uint64_t x 4", n, rounds, seed);
+    measure<double,4>  ("double   x 4", n, rounds, seed);
+    measure<double,8>  ("double   x 8", n, rounds, seed);
+    return 0;
+}
@@ -0,0 +1,272 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   BatchQuery.h
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#ifndef PDAAAL_BATCHQUERY_H
+#define PDAAAL_BATCHQUERY_H
+
+#include "PAutomaton.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pdaaal {
+
+    // Answers many acceptance queries on one (saturated) automaton.
+    // A query is either a configuration (state, stack), answered like PAutomaton::accepts,
+    // or a set of states and an NFA, which is true iff the automaton accepts <p,w> for some p in the set and w in the language of the NFA.
+    // Configuration queries are stored in a trie per start state, so queries with a common stack prefix share the search for that prefix,
+    // and each trie node is expanded with one pass over the outgoing edges of the automaton states reached.
+    // NFA queries are answered together by one search of the products of the automaton with all query automata.
+    template <typename W = void, typename C = std::less<W>, typename A = add<W>>
+    class BatchQuery {
+        using automaton_t = PAutomaton<W,C,A>;
+        static constexpr auto epsilon = automaton_t::epsilon;
+        static constexpr auto wildcard = automaton_t::wildcard;
+
+        struct node_t {
+            std::vector<std::pair<uint32_t,size_t>> _children; // (label, node). Sorted by label.
+            std::vector<size_t> _queries; // Queries whose stack ends here.
+        };
+        struct nfa_query_t {
+            size_t _query;
+            std::vector<size_t> _states;
+            std::unique_ptr<automaton_t> _automaton; // Accepts <p,w> iff p in _states and w in the language of the NFA.
+        };
+
+    public:
+        explicit BatchQuery(const automaton_t& automaton) : _automaton(automaton) {};
+
+        // Add a query for the configuration <state, stack>. Returns the id of the query, which indexes the result of run().
+        size_t add(size_t state, const std::vector<uint32_t>& stack) {
+            auto id = _n_queries++;
+            auto [it, fresh] = _roots.emplace(state, _nodes.size());
+            if (fresh) {
+                _nodes.emplace_back();
+            }
+            size_t node = it->second;
+            for (auto label : stack) {
+                auto& children = _nodes[node]._children;
+                auto lb = std::lower_bound(children.begin(), children.end(), std::make_pair(label, size_t(0)));
+                if (lb != children.end() && lb->first == label) {
+                    node = lb->second;
+                } else {
+                    children.insert(lb, std::make_pair(label, _nodes.size()));
+                    node = _nodes.size();
+                    _nodes.emplace_back(); // Invalidates children.
+                }
+            }
+            _nodes[node]._queries.push_back(id);
+            return id;
+        }
+
+        // Add a query for the configurations <p,w>, where p is in states and w is accepted by nfa. Returns the id of the query.
+        template <typename T>
+        size_t add(const TypedPDA<T,W,C>& pda, std::vector<size_t> states, const NFA<T>& nfa) {
+            std::sort(states.begin(), states.end());
+            states.erase(std::unique(states.begin(), states.end()), states.end());
+            auto id = _n_queries++;
+            auto query_automaton = std::make_unique<automaton_t>(pda, nfa, states);
+            _nfa_queries.push_back(nfa_query_t{id, std::move(states), std::move(query_automaton)});
+            return id;
+        }
+
+        // Answer all queries added so far. Result i is the answer to the query with id i.
+        const std::vector<bool>& run() {
+            auto start = std::chrono::steady_clock::now();
+            _result.assign(_n_queries, false);
+            for (const auto& [state, root] : _roots) {
+                search_trie(state, root);
+            }
+            search_products();
+            _duration = std::chrono::steady_clock::now() - start;
+            return _result;
+        }
+
+        [[nodiscard]] const std::vector<bool>& result() const { return _result; }
+        [[nodiscard]] size_t size() const { return _n_queries; }
+        // Throughput of the last call to run().
+        [[nodiscard]] double queries_per_second() const {
+            auto seconds = _duration.count();
+            return seconds > 0 ? static_cast<double>(_n_queries) / seconds : 0;
+        }
+        [[nodiscard]] double run_time() const { return _duration.count(); }
+
+        void clear() {
+            _roots.clear();
+            _nodes.clear();
+            _nfa_queries.clear();
+            _result.clear();
+            _n_queries = 0;
+        }
+
+    private:
+        const automaton_t& _automaton;
+        std::unordered_map<size_t,size_t> _roots; // Start state -> trie node
+        std::vector<node_t> _nodes;
+        std::vector<nfa_query_t> _nfa_queries;
+        size_t _n_queries = 0;
+        std::vector<bool> _result;
+        std::chrono::duration<double> _duration{0};
+        std::vector<bool> _seen; // Buffers for search_products, kept between runs.
+        std::vector<std::vector<std::pair<size_t,size_t>>> _pending;
+
+        void search_trie(size_t state, size_t root) {
+            std::vector<std::pair<size_t, std::vector<size_t>>> waiting; // (trie node, automaton states reached)
+            waiting.emplace_back(root, std::vector<size_t>{state});
+            std::vector<std::vector<size_t>> next;
+            while (!waiting.empty()) {
+                auto [node, states] = std::move(waiting.back());
+                waiting.pop_back();
+                const auto& [children, queries] = _nodes[node];
+                if (!queries.empty()) {
+                    bool accepted = std::any_of(states.begin(), states.end(), [this](size_t s){ return _automaton.states()[s]->_accepting; });
+                    for (auto query : queries) {
+                        _result[query] = accepted;
+                    }
+                }
+                if (children.empty()) continue;
+                // One pass over the edges, distributing the target states to the children with a matching label.
+                next.assign(children.size(), std::vector<size_t>());
+                for (auto from : states) {
+                    for (const auto& [to, labels] : _automaton.states()[from]->_edges) {
+                        for (const auto& [label, _] : labels) {
+                            if (label == epsilon) continue;
+                            if (label == wildcard) {
+                                for (size_t i = 0; i < children.size(); ++i) {
+                                    next[i].push_back(to);
+                                }
+                            } else {
+                                auto lb = std::lower_bound(children.begin(), children.end(), std::make_pair(label, size_t(0)));
+                                if (lb != children.end() && lb->first == label) {
+                                    next[lb - children.begin()].push_back(to);
+                                }
+                            }
+                        }
+                    }
+                }
+                for (size_t i = 0; i < children.size(); ++i) {
+                    auto& reached = next[i];
+                    if (reached.empty()) continue; // All queries below this child are false.
+                    std::sort(reached.begin(), reached.end());
+                    reached.erase(std::unique(reached.begin(), reached.end()), reached.end());
+                    waiting.emplace_back(children[i].second, std::move(reached));
+                }
+            }
+        }
+
+        // Whether the labels of two edges have a common (non-epsilon) label.
+        template <typename Labels>
+        static bool labels_intersect(const Labels& la, const Labels& lb) {
+            auto non_epsilon = [](const Labels& labels) { return labels.size() > (labels.contains(epsilon) ? 1 : 0); };
+            if (la.contains(wildcard)) return non_epsilon(lb);
+            if (lb.contains(wildcard)) return non_epsilon(la);
+            auto it_a = la.begin();
+            auto it_b = lb.begin();
+            while (it_a != la.end() && it_b != lb.end()) {
+                if (it_a->first < it_b->first) {
+                    ++it_a;
+                } else if (it_b->first < it_a->first) {
+                    ++it_b;
+                } else if (it_a->first == epsilon) {
+                    return false; // epsilon is the largest label, so there is nothing after it.
+                } else {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Search the products of the automaton and the query automata for pairs of accepting states.
+        // The states of the query automata are numbered one after the other, so one seen vector covers all products.
+        // Pairs are grouped by their state in the automaton, so each pass over the edges of an automaton state serves all queries that reached it.
+        void search_products() {
+            if (_nfa_queries.empty()) return;
+            std::vector<size_t> offsets; // The states of query automaton k are offsets[k] to offsets[k+1]-1.
+            offsets.reserve(_nfa_queries.size() + 1);
+            offsets.push_back(0);
+            for (const auto& query : _nfa_queries) {
+                offsets.push_back(offsets.back() + query._automaton->states().size());
+            }
+            const size_t n_other = offsets.back();
+            const size_t n_states = _automaton.states().size();
+            _seen.assign(n_states * n_other, false);
+            _pending.resize(std::max(_pending.size(), n_states));
+            std::vector<bool> answered(_nfa_queries.size(), false);
+            size_t n_open = _nfa_queries.size();
+            std::vector<size_t> waiting; // Automaton states with pending pairs.
+            auto visit = [&](size_t a, size_t k, size_t b) {
+                auto index = a * n_other + offsets[k] + b;
+                if (_seen[index]) return;
+                _seen[index] = true;
+                if (_pending[a].empty()) {
+                    waiting.push_back(a);
+                }
+                _pending[a].emplace_back(k, b);
+            };
+            for (size_t k = 0; k < _nfa_queries.size(); ++k) {
+                for (auto state : _nfa_queries[k]._states) {
+                    visit(state, k, state);
+                }
+            }
+            std::vector<std::pair<size_t,size_t>> pairs; // (query, query automaton state)
+            while (!waiting.empty() && n_open > 0) {
+                auto a = waiting.back();
+                waiting.pop_back();
+                pairs.swap(_pending[a]);
+                const auto& a_state = *_automaton.states()[a];
+                if (a_state._accepting) {
+                    for (auto [k, b] : pairs) {
+                        if (!answered[k] && _nfa_queries[k]._automaton->states()[b]->_accepting) {
+                            answered[k] = true;
+                            _result[_nfa_queries[k]._query] = true;
+                            --n_open;
+                        }
+                    }
+                }
+                for (const auto& [a_to, a_labels] : a_state._edges) {
+                    for (auto [k, b] : pairs) {
+                        if (answered[k]) continue;
+                        for (const auto& [b_to, b_labels] : _nfa_queries[k]._automaton->states()[b]->_edges) {
+                            if (labels_intersect(a_labels, b_labels)) {
+                                visit(a_to, k, b_to);
+                            }
+                        }
+                    }
+                }
+                pairs.clear();
+            }
+            for (auto a : waiting) { // Left over when all queries were answered early.
+                _pending[a].clear();
+            }
+        }
+    };
+
+}
+
+#endif //PDAAAL_BATCHQUERY_H
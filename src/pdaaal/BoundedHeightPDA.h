@@ -0,0 +1,155 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   BoundedHeightPDA.h
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#ifndef PDAAAL_BOUNDEDHEIGHTPDA_H
+#define PDAAAL_BOUNDEDHEIGHTPDA_H
+
+#include "PDA.h"
+#include "PAutomaton.h"
+#include <cassert>
+#include <limits>
+#include <vector>
+
+namespace pdaaal {
+
+    // The product of a PDA and the stack heights 0..max_height. State (p, h) has stack height h,
+    // and a rule of p is applied in (p, h) only if the resulting stack height is at most max_height.
+    // So the configurations <(p, |w|), w> reachable in this PDA are exactly the configurations <p, w> reachable in the original PDA
+    // by traces where no configuration has stack height above max_height, and the same holds for pre*.
+    //
+    // Saturate an automaton from bounded_automaton() with the usual Solver::pre_star or Solver::post_star.
+    // The saturation never creates edges for configurations above the bound, so long Q' chains and deep stacks are pruned.
+    // Traces use the states of this PDA, which are mapped back by pda_state().
+    template <typename W, typename C = std::less<W>>
+    class BoundedHeightPDA : public PDA<W,C> {
+    public:
+        BoundedHeightPDA(const PDA<W,C>& pda, size_t max_height)
+        : _n_pda_states(pda.states().size()), _max_height(max_height), _n_labels(pda.number_of_labels()) {
+            this->states_mutable().resize(_n_pda_states * (_max_height + 1));
+            for (size_t p = 0; p < _n_pda_states; ++p) {
+                for (const auto& [rule, labels] : pda.states()[p]._rules) {
+                    for (size_t h = 1; h <= _max_height; ++h) { // A rule needs a top of stack, so height 0 has no rules.
+                        size_t to_height = h;
+                        switch (rule._operation) {
+                            case POP:
+                                --to_height;
+                                break;
+                            case PUSH:
+                                ++to_height;
+                                break;
+                            case SWAP:
+                            case NOOP:
+                                break;
+                        }
+                        if (to_height > _max_height) continue;
+                        auto r = rule;
+                        r._to = state(rule._to, to_height);
+                        this->add_untyped_rule_impl(state(p, h), r, labels.wildcard(), labels.labels());
+                    }
+                }
+            }
+        };
+
+        [[nodiscard]] size_t number_of_labels() const override { return _n_labels; }
+        [[nodiscard]] size_t max_height() const { return _max_height; }
+
+        [[nodiscard]] size_t state(size_t pda_state, size_t height) const {
+            assert(pda_state < _n_pda_states && height <= _max_height);
+            return pda_state * (_max_height + 1) + height;
+        }
+        [[nodiscard]] size_t pda_state(size_t state) const { return state / (_max_height + 1); }
+        [[nodiscard]] size_t height(size_t state) const { return state % (_max_height + 1); }
+
+        // An automaton over this PDA that accepts <(p, |w|), w> iff the given (initial) automaton accepts <p, w> and |w| <= max_height.
+        // Each state of the given automaton is copied once per number of remaining labels, so the height of a configuration is known from its path.
+        template <typename A>
+        PAutomaton<W,C,A> bounded_automaton(const PAutomaton<W,C,A>& automaton) const {
+            using automaton_t = PAutomaton<W,C,A>;
+            constexpr auto none = std::numeric_limits<size_t>::max();
+            const auto& states = automaton.states();
+            std::vector<size_t> accepting_states;
+            for (size_t p = 0; p < _n_pda_states; ++p) {
+                if (states[p]->_accepting) {
+                    accepting_states.push_back(state(p, 0));
+                }
+            }
+            automaton_t result(*this, accepting_states);
+            // layered[(q - _n_pda_states) * _max_height + r] is the copy of q with r remaining labels (r < _max_height).
+            std::vector<size_t> layered((states.size() - _n_pda_states) * _max_height, none);
+            std::vector<std::pair<size_t,size_t>> waiting; // (state in automaton, remaining labels)
+            auto get_state = [&](size_t q, size_t r) -> size_t {
+                if (q < _n_pda_states) {
+                    return state(q, r);
+                }
+                auto& id = layered[(q - _n_pda_states) * _max_height + r];
+                if (id == none) {
+                    id = result.add_state(false, r == 0 && states[q]->_accepting);
+                    waiting.emplace_back(q, r);
+                }
+                return id;
+            };
+            auto copy_edges = [&](size_t from, size_t r, size_t result_from) {
+                if (r == 0) return;
+                for (const auto& [to, labels] : states[from]->_edges) {
+                    for (const auto& [label, trace] : labels) {
+                        assert(label != automaton_t::epsilon); // Like pre* and post*, we assume no epsilon transitions in the initial automaton.
+                        auto result_to = get_state(to, r - 1);
+                        if (label == automaton_t::wildcard) {
+                            result.add_wildcard_edge(result_from, result_to);
+                        } else {
+                            result.add_edge(result_from, result_to, label);
+                        }
+                    }
+                }
+            };
+            for (size_t p = 0; p < _n_pda_states; ++p) {
+                for (size_t h = 1; h <= _max_height; ++h) {
+                    copy_edges(p, h, state(p, h));
+                }
+            }
+            while (!waiting.empty()) {
+                auto [q, r] = waiting.back();
+                waiting.pop_back();
+                copy_edges(q, r, layered[(q - _n_pda_states) * _max_height + r]);
+            }
+            return result;
+        }
+
+        // Whether an automaton over this PDA accepts the configuration <pda_state, stack> of the original PDA.
+        template <typename A>
+        [[nodiscard]] bool accepts(const PAutomaton<W,C,A>& automaton, size_t pda_state, const std::vector<uint32_t>& stack) const {
+            return stack.size() <= _max_height && automaton.accepts(state(pda_state, stack.size()), stack);
+        }
+
+    private:
+        const size_t _n_pda_states;
+        const size_t _max_height;
+        const size_t _n_labels;
+    };
+
+}
+
+#endif //PDAAAL_BOUNDEDHEIGHTPDA_H
@@ -0,0 +1,229 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   CompiledPDA.h
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#ifndef PDAAAL_COMPILEDPDA_H
+#define PDAAAL_COMPILEDPDA_H
+
+#include "PDA.h"
+#include "rule_index.h"
+#include "q_prime_table.h"
+#include "std20.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <boost/container_hash/hash.hpp>
+
+namespace pdaaal {
+
+    // The precondition of a compiled rule: either wildcard, or a sorted range of labels.
+    // Has the same interface as labels_t, where labels() is the range itself.
+    class labels_view {
+    public:
+        labels_view(bool wildcard, std20::span<uint32_t> labels) : _wildcard(wildcard), _labels(labels) {};
+
+        [[nodiscard]] bool wildcard() const { return _wildcard; }
+        [[nodiscard]] const std20::span<uint32_t>& labels() const { return _labels; }
+        [[nodiscard]] bool empty() const { return !_wildcard && _labels.empty(); }
+        [[nodiscard]] bool contains(uint32_t label) const {
+            return _wildcard || std::binary_search(_labels.begin(), _labels.end(), label);
+        }
+
+    private:
+        bool _wildcard;
+        std20::span<uint32_t> _labels;
+    };
+
+    // Immutable snapshot of the rules of a PDA in CSR layout, used by the saturation algorithms.
+    // The forward rules of each state are stored in one array (with the same rule ids as in the PDA), the preconditions in another,
+    // and the reverse index gives the rules going into each state, grouped by operation.
+    // It also holds the rule_index and q_prime_table used by post*.
+    // A CompiledPDA is only read after construction, so it can be shared between threads and between solves on PDAs with the same rules.
+    template <typename W, typename C>
+    class CompiledPDA {
+    public:
+        using rule_t = details::rule_t<W,C>;
+        // Rule number _rule_id of state _from.
+        struct rule_ref_t {
+            size_t _from;
+            size_t _rule_id;
+        };
+
+        // The rules of one state. rules[i] is a pair of the rule and its precondition, like PDA::state_t::_rules[i].
+        class rules_view {
+        public:
+            rules_view(const CompiledPDA& pda, size_t begin, size_t end) : _pda(pda), _begin(begin), _end(end) {};
+            [[nodiscard]] size_t size() const { return _end - _begin; }
+            [[nodiscard]] bool empty() const { return _begin == _end; }
+            std::pair<const rule_t&, labels_view> operator[](size_t rule_id) const {
+                assert(_begin + rule_id < _end);
+                return {_pda._rules[_begin + rule_id], _pda.labels(_begin + rule_id)};
+            }
+        private:
+            const CompiledPDA& _pda;
+            size_t _begin;
+            size_t _end;
+        };
+
+        explicit CompiledPDA(const PDA<W,C>& pda) : _q_prime(pda.states()) {
+            compile(pda);
+        }
+        // Compile pda after its rules were changed, keeping the numbering of the Q' states in previous.
+        CompiledPDA(const PDA<W,C>& pda, const CompiledPDA& previous) : _q_prime(previous._q_prime) {
+            _q_prime.update(pda.states());
+            compile(pda);
+        }
+
+        [[nodiscard]] size_t number_of_states() const { return _rule_offsets.size() - 1; }
+        [[nodiscard]] size_t number_of_rules() const { return _rules.size(); }
+        [[nodiscard]] rules_view rules(size_t state) const {
+            return rules_view(*this, _rule_offsets[state], _rule_offsets[state + 1]);
+        }
+        // The rules <p, y> -> <to, w> with the given operation, ordered by p and rule id.
+        [[nodiscard]] std20::span<rule_ref_t> rules_into(size_t to, op_t operation) const {
+            auto i = to * n_operations + operation_index(operation);
+            return std20::span<rule_ref_t>(_reverse.data() + _reverse_offsets[i], _reverse_offsets[i + 1] - _reverse_offsets[i]);
+        }
+        [[nodiscard]] const details::rule_index& label_index() const { return _label_index; }
+        [[nodiscard]] const details::q_prime_table& q_prime() const { return _q_prime; }
+
+        // Whether pda has the same number of states and the same number of rules in each state as the compiled PDA.
+        // This is a cheap check that the compiled PDA was made from (a copy of) pda.
+        [[nodiscard]] bool matches(const PDA<W,C>& pda) const {
+            const auto& states = pda.states();
+            if (states.size() != number_of_states()) return false;
+            for (size_t state = 0; state < states.size(); ++state) {
+                if (states[state]._rules.size() != _rule_offsets[state + 1] - _rule_offsets[state]) return false;
+            }
+            return true;
+        }
+        // Like matches, but also compares a hash of the rules, preconditions and weights. This reads all rules of pda,
+        // so it is only used in assertions.
+        [[nodiscard]] bool same_rules(const PDA<W,C>& pda) const {
+            return matches(pda) && fingerprint(pda) == _fingerprint;
+        }
+
+    private:
+        static constexpr size_t n_operations = 4;
+        static constexpr size_t operation_index(op_t operation) {
+            switch (operation) {
+                case PUSH: return 0;
+                case POP: return 1;
+                case SWAP: return 2;
+                case NOOP: return 3;
+            }
+            assert(false);
+            return 0;
+        }
+
+        std::vector<size_t> _rule_offsets;    // The rules of state p are _rules[_rule_offsets[p]] to _rules[_rule_offsets[p+1]-1].
+        std::vector<rule_t> _rules;
+        std::vector<size_t> _label_offsets;   // The precondition of _rules[i] is _labels[_label_offsets[i]] to _labels[_label_offsets[i+1]-1],
+        std::vector<bool> _wildcard;          // unless _wildcard[i].
+        std::vector<uint32_t> _labels;
+        std::vector<size_t> _reverse_offsets; // Indexed by to * n_operations + operation_index(operation).
+        std::vector<rule_ref_t> _reverse;
+        details::rule_index _label_index;
+        details::q_prime_table _q_prime;
+        size_t _fingerprint = 0;
+
+        static size_t fingerprint(const PDA<W,C>& pda) {
+            typename rule_t::hasher rule_hasher;
+            size_t seed = pda.states().size();
+            for (const auto& state : pda.states()) {
+                boost::hash_combine(seed, state._rules.size());
+                for (const auto& [rule, labels] : state._rules) {
+                    boost::hash_combine(seed, rule_hasher(rule));
+                    boost::hash_combine(seed, labels.wildcard());
+                    boost::hash_range(seed, labels.labels().begin(), labels.labels().end());
+                }
+            }
+            return seed;
+        }
+
+        [[nodiscard]] labels_view labels(size_t i) const {
+            return labels_view(_wildcard[i], std20::span<uint32_t>(_labels.data() + _label_offsets[i], _label_offsets[i + 1] - _label_offsets[i]));
+        }
+
+        void compile(const PDA<W,C>& pda) {
+            const auto& states = pda.states();
+            size_t n_rules = 0;
+            for (const auto& state : states) {
+                n_rules += state._rules.size();
+            }
+            _rule_offsets.reserve(states.size() + 1);
+            _rules.reserve(n_rules);
+            _label_offsets.reserve(n_rules + 1);
+            _wildcard.reserve(n_rules);
+            std::vector<size_t> reverse_count(states.size() * n_operations + 1, 0);
+            for (const auto& state : states) {
+                _rule_offsets.push_back(_rules.size());
+                for (const auto& [rule, labels] : state._rules) {
+                    _rules.push_back(rule);
+                    _label_offsets.push_back(_labels.size());
+                    _wildcard.push_back(labels.wildcard());
+                    _labels.insert(_labels.end(), labels.labels().begin(), labels.labels().end());
+                    ++reverse_count[rule._to * n_operations + operation_index(rule._operation)];
+                }
+            }
+            _rule_offsets.push_back(_rules.size());
+            _label_offsets.push_back(_labels.size());
+
+            // Counting sort of the rules by (to, operation). Iterating over the rules in order keeps each group ordered by (from, rule id).
+            _reverse_offsets.assign(reverse_count.size(), 0);
+            for (size_t i = 1; i < reverse_count.size(); ++i) {
+                _reverse_offsets[i] = _reverse_offsets[i - 1] + reverse_count[i - 1];
+            }
+            _reverse.resize(_rules.size());
+            std::vector<size_t> next(_reverse_offsets.begin(), _reverse_offsets.end() - 1);
+            for (size_t from = 0; from < states.size(); ++from) {
+                for (size_t rule_id = 0; rule_id < _rule_offsets[from + 1] - _rule_offsets[from]; ++rule_id) {
+                    const auto& rule = _rules[_rule_offsets[from] + rule_id];
+                    _reverse[next[rule._to * n_operations + operation_index(rule._operation)]++] = rule_ref_t{from, rule_id};
+                }
+            }
+            _label_index = details::rule_index(states);
+            _fingerprint = fingerprint(pda);
+        }
+    };
+
+    // Compile pda for use in the saturation algorithms of Solver. The result can be shared between solves on pda.
+    // It is cached in pda until the rules of pda change, so solves without an explicit compiled PDA only compile it once.
+    template <typename W, typename C>
+    std::shared_ptr<const CompiledPDA<W,C>> compile_pda(const PDA<W,C>& pda) {
+        auto compiled = std::atomic_load(&pda._compiled);
+        if (!compiled) {
+            compiled = std::make_shared<const CompiledPDA<W,C>>(pda);
+            std::atomic_store(&pda._compiled, compiled);
+        }
+        return compiled;
+    }
+
+}
+
+#endif //PDAAAL_COMPILEDPDA_H
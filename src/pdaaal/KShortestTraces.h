@@ -0,0 +1,342 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   KShortestTraces.h
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#ifndef PDAAAL_KSHORTESTTRACES_H
+#define PDAAAL_KSHORTESTTRACES_H
+
+#include "PAutomaton.h"
+#include "TypedPDA.h"
+#include <algorithm>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/container_hash/hash.hpp>
+
+namespace pdaaal {
+
+    // Enumerates the traces of a weighted PDA in order of increasing weight, using an automaton saturated by
+    // Solver::pre_star<Trace_Type::Shortest> or Solver::post_star<Trace_Type::Shortest>.
+    // For pre*, the traces go from the given configuration to a configuration accepted by the initial automaton.
+    // For post*, the traces go from a configuration accepted by the initial automaton to the given configuration.
+    //
+    // The weight of the shortest accepting path of a configuration in the saturated automaton is its exact distance to
+    // (pre*) or from (post*) the initial configurations, so it is used as the heuristic of an A* search over configurations,
+    // which goes forwards from the given configuration for pre* and backwards for post*.
+    // Since the heuristic is exact, every configuration that is explored is on a trace, and a trace is found every time
+    // an initial configuration is popped from the queue. Paths are not merged, so the same configuration can be explored
+    // once for each trace through it. The distance and whether it is initial are computed once per configuration.
+    // Rules that give the same successor (e.g. rules that only differ in weight) are applied as the cheapest of them,
+    // so traces are distinct sequences of configurations.
+    // Ties are broken in the order configurations were found, so all traces of equal weight are eventually found,
+    // also when zero-weight cycles give infinitely many of them.
+    template <typename T, typename W, typename C, typename A>
+    class KShortestTraces {
+        static_assert(is_weighted<W>);
+        using automaton_t = PAutomaton<W,C,A>;
+        static constexpr auto epsilon = automaton_t::epsilon;
+        static constexpr auto wildcard = automaton_t::wildcard;
+    public:
+        using tracestate_t = typename TypedPDA<T,W,C>::tracestate_t;
+
+        KShortestTraces(const TypedPDA<T,W,C>& pda, const automaton_t& automaton, bool post, size_t state, std::vector<uint32_t> stack)
+        : _pda(pda), _automaton(automaton), _post(post) {
+            auto& config = get_config(state, std::move(stack));
+            if (config.second._distance != max<W>()()) {
+                push(config, zero<W>()(), no_parent);
+            }
+        };
+        // Nodes point into _configs, so a copy would point into the original.
+        KShortestTraces(const KShortestTraces&) = delete;
+        KShortestTraces(KShortestTraces&&) noexcept = default;
+
+        // The next cheapest trace and its weight, or std::nullopt if there are no more traces.
+        std::optional<std::pair<std::vector<tracestate_t>, W>> next() {
+            while (!_queue.empty()) {
+                auto [f, id] = _queue.top();
+                _queue.pop();
+                expand(id);
+                auto& config = *_nodes[id]._config;
+                if (!config.second._initial) {
+                    config.second._initial = is_initial(config.first.first, config.first.second);
+                }
+                if (config.second._initial.value()) {
+                    return std::make_pair(get_trace(id), _nodes[id]._weight);
+                }
+            }
+            return std::nullopt;
+        }
+        // The next (at most) k cheapest traces.
+        std::vector<std::pair<std::vector<tracestate_t>, W>> take(size_t k) {
+            std::vector<std::pair<std::vector<tracestate_t>, W>> traces;
+            for (; k > 0; --k) {
+                auto trace = next();
+                if (!trace) break;
+                traces.emplace_back(std::move(trace.value()));
+            }
+            return traces;
+        }
+
+    private:
+        static constexpr size_t no_parent = std::numeric_limits<size_t>::max();
+        using config_t = std::pair<size_t, std::vector<uint32_t>>; // (state, stack) with top of stack first.
+        struct config_info_t {
+            W _distance = max<W>()(); // See distance().
+            std::optional<bool> _initial; // See is_initial(). Computed when the configuration is first popped.
+        };
+        using config_map_t = std::unordered_map<config_t, config_info_t, boost::hash<config_t>>;
+        using config_entry_t = typename config_map_t::value_type;
+        struct node_t {
+            config_entry_t* _config; // Elements of an unordered_map are not moved by rehashing.
+            W _weight; // Weight of the rules applied from the given configuration.
+            size_t _parent;
+        };
+        struct queue_elem_comp {
+            bool operator()(const std::pair<W,size_t>& lhs, const std::pair<W,size_t>& rhs) const {
+                weight_compare_t<W,C> less;
+                // Used in a max-heap, so swap arguments to make it a min-heap. Ties are broken by the order nodes were added.
+                if (less(rhs.first, lhs.first)) return true;
+                if (less(lhs.first, rhs.first)) return false;
+                return rhs.second < lhs.second;
+            }
+        };
+
+        const A _add{};
+        const TypedPDA<T,W,C>& _pda;
+        const automaton_t& _automaton;
+        const bool _post;
+        std::vector<node_t> _nodes;
+        std::priority_queue<std::pair<W,size_t>, std::vector<std::pair<W,size_t>>, queue_elem_comp> _queue;
+        config_map_t _configs;
+        std::vector<size_t> _visited; // _visited[i] == _visit_stamp iff i was visited in the current call of distance() or is_initial().
+        size_t _visit_stamp = 0;
+        // Successors found by the current call of expand(), with the cheapest rule weight for each.
+        std::vector<std::pair<config_entry_t*, W>> _successors;
+        std::unordered_map<const config_entry_t*, size_t> _successor_index;
+
+        config_entry_t& get_config(size_t state, std::vector<uint32_t>&& stack) {
+            auto [it, inserted] = _configs.try_emplace(config_t{state, std::move(stack)});
+            if (inserted) {
+                it->second._distance = distance(it->first.first, it->first.second);
+            }
+            return *it;
+        }
+        void push(config_entry_t& config, W weight, size_t parent) {
+            _queue.emplace(_add(weight, config.second._distance), _nodes.size());
+            _nodes.push_back(node_t{&config, weight, parent});
+        }
+        // Add the configuration as a successor, unless no trace goes through it.
+        void add_successor(size_t state, std::vector<uint32_t>&& stack, const W& rule_weight) {
+            auto& config = get_config(state, std::move(stack));
+            if (config.second._distance == max<W>()()) return;
+            auto [it, inserted] = _successor_index.emplace(&config, _successors.size());
+            if (inserted) {
+                _successors.emplace_back(&config, rule_weight);
+            } else if (weight_compare_t<W,C>{}(rule_weight, _successors[it->second].second)) {
+                _successors[it->second].second = rule_weight;
+            }
+        }
+
+        void expand(size_t id) {
+            _successors.clear();
+            _successor_index.clear();
+            find_successors(id);
+            for (const auto& [config, rule_weight] : _successors) {
+                push(*config, _add(_nodes[id]._weight, rule_weight), id);
+            }
+        }
+
+        void find_successors(size_t id) {
+            const auto& pda_states = _pda.states();
+            auto state = _nodes[id]._config->first.first;
+            const auto& stack = _nodes[id]._config->first.second;
+            if (!_post) {
+                // Successors of <p, y w>.
+                if (stack.empty()) return;
+                for (const auto& [rule, labels] : pda_states[state]._rules) {
+                    if (!labels.contains(stack[0])) continue;
+                    auto post_stack = stack;
+                    switch (rule._operation) {
+                        case POP:
+                            post_stack.erase(post_stack.begin());
+                            break;
+                        case SWAP:
+                            post_stack[0] = rule._op_label;
+                            break;
+                        case NOOP:
+                            break;
+                        case PUSH:
+                            post_stack.insert(post_stack.begin(), rule._op_label);
+                            break;
+                    }
+                    add_successor(rule._to, std::move(post_stack), rule._weight);
+                }
+            } else {
+                // Predecessors of <p', w'>.
+                const auto n_labels = static_cast<uint32_t>(_pda.number_of_labels());
+                for (auto from : pda_states[state]._pre_states) {
+                    for (const auto& rule_labels : pda_states[from]._rules) {
+                        const auto& rule = rule_labels.first;
+                        const auto& labels = rule_labels.second;
+                        if (rule._to != state) continue;
+                        auto add_with_top = [&](size_t n_popped) { // <p, y w> for each y in the precondition, where w is stack without n_popped labels.
+                            auto add_label = [&](uint32_t y) {
+                                std::vector<uint32_t> pre_stack;
+                                pre_stack.reserve(stack.size() + 1 - n_popped);
+                                pre_stack.push_back(y);
+                                pre_stack.insert(pre_stack.end(), stack.begin() + n_popped, stack.end());
+                                add_successor(from, std::move(pre_stack), rule._weight);
+                            };
+                            if (labels.wildcard()) {
+                                for (uint32_t y = 0; y < n_labels; ++y) add_label(y);
+                            } else {
+                                for (auto y : labels.labels()) add_label(y);
+                            }
+                        };
+                        switch (rule._operation) {
+                            case POP: // <p, y w'> -> <p', w'>
+                                add_with_top(0);
+                                break;
+                            case SWAP: // <p, y w> -> <p', y' w>
+                                if (!stack.empty() && stack[0] == rule._op_label) {
+                                    add_with_top(1);
+                                }
+                                break;
+                            case NOOP: // <p, y w> -> <p', y w>
+                                if (!stack.empty() && labels.contains(stack[0])) {
+                                    add_successor(from, std::vector<uint32_t>(stack), rule._weight);
+                                }
+                                break;
+                            case PUSH: // <p, y w> -> <p', y' y w>
+                                if (stack.size() >= 2 && stack[0] == rule._op_label && labels.contains(stack[1])) {
+                                    add_successor(from, std::vector<uint32_t>(stack.begin() + 1, stack.end()), rule._weight);
+                                }
+                                break;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Weight of the shortest path accepting <state, stack> in the automaton, or max<W> if it is not accepted.
+        W distance(size_t state, const std::vector<uint32_t>& stack) {
+            using elem_t = std::tuple<W,size_t,size_t>; // (weight, stack index, state)
+            struct elem_comp {
+                bool operator()(const elem_t& lhs, const elem_t& rhs) const {
+                    weight_compare_t<W,C> less;
+                    return less(std::get<0>(rhs), std::get<0>(lhs));
+                }
+            };
+            const auto& states = _automaton.states();
+            std::priority_queue<elem_t, std::vector<elem_t>, elem_comp> queue;
+            start_visit(stack.size());
+            queue.emplace(zero<W>()(), 0, state);
+            while (!queue.empty()) {
+                auto [weight, index, current] = queue.top();
+                queue.pop();
+                if (!visit(current * (stack.size() + 1) + index)) continue;
+                if (index == stack.size() && states[current]->_accepting) return weight;
+                for (const auto& [to, labels] : states[current]->_edges) {
+                    if (auto eps = labels.get(epsilon); eps != nullptr) {
+                        queue.emplace(_add(weight, eps->second), index, to);
+                    }
+                    if (index == stack.size()) continue;
+                    auto label = labels.get(stack[index]);
+                    auto wildcard_label = labels.get(wildcard);
+                    if (label == nullptr || (wildcard_label != nullptr && weight_compare_t<W,C>{}(wildcard_label->second, label->second))) {
+                        label = wildcard_label;
+                    }
+                    if (label != nullptr) {
+                        queue.emplace(_add(weight, label->second), index + 1, to);
+                    }
+                }
+            }
+            return max<W>()();
+        }
+
+        // Whether <state, stack> is accepted using only edges of the initial automaton, i.e. edges without a trace.
+        bool is_initial(size_t state, const std::vector<uint32_t>& stack) {
+            const auto& states = _automaton.states();
+            std::vector<std::pair<size_t,size_t>> waiting{{state, 0}};
+            start_visit(stack.size());
+            while (!waiting.empty()) {
+                auto [current, index] = waiting.back();
+                waiting.pop_back();
+                if (!visit(current * (stack.size() + 1) + index)) continue;
+                if (index == stack.size()) {
+                    if (states[current]->_accepting) return true;
+                    continue;
+                }
+                for (const auto& [to, labels] : states[current]->_edges) {
+                    auto label = labels.get(stack[index]);
+                    auto wildcard_label = labels.get(wildcard);
+                    if ((label != nullptr && trace_from<W>(*label) == no_trace) ||
+                        (wildcard_label != nullptr && trace_from<W>(*wildcard_label) == no_trace)) {
+                        waiting.emplace_back(to, index + 1);
+                    }
+                }
+            }
+            return false;
+        }
+
+        // Reuse _visited for a search over (automaton state, stack index) pairs, without clearing it.
+        void start_visit(size_t stack_size) {
+            auto size = _automaton.states().size() * (stack_size + 1);
+            if (_visited.size() < size) {
+                _visited.resize(size, _visit_stamp);
+            }
+            ++_visit_stamp;
+        }
+        // Mark i as visited, and return whether it was not visited before.
+        bool visit(size_t i) {
+            if (_visited[i] == _visit_stamp) return false;
+            _visited[i] = _visit_stamp;
+            return true;
+        }
+
+        std::vector<tracestate_t> get_trace(size_t id) const {
+            std::vector<tracestate_t> trace;
+            for (; id != no_parent; id = _nodes[id]._parent) {
+                const auto& [state, stack] = _nodes[id]._config->first;
+                tracestate_t trace_state{state, std::vector<T>()};
+                trace_state._stack.reserve(stack.size());
+                for (auto label : stack) {
+                    trace_state._stack.emplace_back(_pda.get_symbol(label));
+                }
+                trace.emplace_back(std::move(trace_state));
+            }
+            if (!_post) {
+                // The search went forwards, so the parent pointers go from the end of the trace to the start.
+                std::reverse(trace.begin(), trace.end());
+            }
+            return trace;
+        }
+    };
+
+}
+
+#endif //PDAAAL_KSHORTESTTRACES_H
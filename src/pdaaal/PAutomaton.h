@@ -32,6 +32,8 @@
 #include "NFA.h"
 
 #include <memory>
+#include <algorithm>
+#include <limits>
 #include <functional>
 #include <vector>
 #include <stack>
@@ -76,24 +78,115 @@ namespace pdaaal {
         [[nodiscard]] bool is_post_epsilon_trace() const {
             return _label == std::numeric_limits<uint32_t>::max();
         }
+
+        bool operator==(const trace_t &other) const {
+            return _state == other._state && _rule_id == other._rule_id && _label == other._label;
+        }
     };
 
-    template<typename W> using trace_ptr = std::conditional_t<is_weighted<W>, std::pair<const trace_t*, W>, const trace_t*>;
+    // Edges refer to traces by their index in the automaton's trace_arena. Index 0 means no trace (an initial edge).
+    using trace_id = uint32_t;
+    constexpr trace_id no_trace = 0;
+
+    namespace details {
+        // Storage for the traces of a PAutomaton. Traces are allocated in chunks that are never moved, so references stay valid,
+        // and they are interned, so equal traces (e.g. the same rule applied many times in pre*) share one record.
+        // The first chunk is small and each chunk is twice the size of the previous one, so small automata only allocate a little.
+        class trace_arena {
+            static constexpr size_t first_chunk_bits = 4;
+            static constexpr size_t first_chunk_size = size_t(1) << first_chunk_bits;
+            static constexpr size_t min_capacity = 16;
+        public:
+            // Returns the id of a trace equal to the given one, adding it if there is none.
+            trace_id intern(const trace_t &trace) {
+                if ((_size + 1) * 4 > _table.size() * 3) { // Max load factor 0.75
+                    rehash(std::max(min_capacity, _table.size() * 2));
+                }
+                size_t i = hash(trace) & _mask;
+                for (; _table[i] != no_trace; i = (i + 1) & _mask) {
+                    if (get(_table[i]) == trace) {
+                        return _table[i];
+                    }
+                }
+                if (_chunks.empty() || _chunks.back().size() == (first_chunk_size << (_chunks.size() - 1))) { // The last chunk is full.
+                    auto chunk_size = first_chunk_size << _chunks.size();
+                    _chunks.emplace_back().reserve(chunk_size);
+                }
+                _chunks.back().push_back(trace);
+                assert(_size < std::numeric_limits<trace_id>::max());
+                _table[i] = static_cast<trace_id>(++_size);
+                return _table[i];
+            }
+
+            [[nodiscard]] const trace_t &get(trace_id id) const {
+                assert(id != no_trace && id <= _size);
+                // Chunk k holds the traces with index i (= id - 1) where 2^(k + first_chunk_bits) <= i + first_chunk_size < 2^(k + first_chunk_bits + 1).
+                size_t j = (id - 1) + first_chunk_size;
+                size_t bits = floor_log2(j);
+                return _chunks[bits - first_chunk_bits][j - (size_t(1) << bits)];
+            }
+
+            [[nodiscard]] size_t size() const { return _size; }
+            [[nodiscard]] size_t memory_bytes() const {
+                return ((first_chunk_size << _chunks.size()) - first_chunk_size) * sizeof(trace_t) + _table.capacity() * sizeof(trace_id);
+            }
+
+        private:
+            std::vector<std::vector<trace_t>> _chunks;
+            std::vector<trace_id> _table; // Open addressing with linear probing. Stores ids of traces in _chunks.
+            size_t _mask = 0;
+            size_t _size = 0;
+
+            static size_t floor_log2(size_t x) {
+                assert(x > 0);
+#if defined(__GNUC__)
+                return std::numeric_limits<unsigned long long>::digits - 1 - __builtin_clzll(x);
+#else
+                size_t result = 0;
+                while (x >>= 1) {
+                    ++result;
+                }
+                return result;
+#endif
+            }
+
+            static size_t hash(const trace_t &trace) {
+                size_t seed = trace._state;
+                boost::hash_combine(seed, trace._rule_id);
+                boost::hash_combine(seed, trace._label);
+                return seed;
+            }
+
+            void rehash(size_t capacity) {
+                _table.assign(capacity, no_trace);
+                _mask = capacity - 1;
+                for (size_t id = 1; id <= _size; ++id) {
+                    size_t i = hash(get(id)) & _mask;
+                    while (_table[i] != no_trace) {
+                        i = (i + 1) & _mask;
+                    }
+                    _table[i] = static_cast<trace_id>(id);
+                }
+            }
+        };
+    }
+
+    template<typename W> using trace_ptr = std::conditional_t<is_weighted<W>, std::pair<trace_id, W>, trace_id>;
     template<typename W> inline constexpr trace_ptr<W> default_trace_ptr() {
         if constexpr (is_weighted<W>) {
-            return std::make_pair<const trace_t*, W>(nullptr, zero<W>()());
+            return std::make_pair(no_trace, zero<W>()());
         } else {
-            return nullptr;
+            return no_trace;
         }
     }
-    template<typename W> inline constexpr trace_ptr<W> trace_ptr_from(const trace_t *trace) {
+    template<typename W> inline constexpr trace_ptr<W> trace_ptr_from(trace_id trace) {
         if constexpr (is_weighted<W>) {
             return std::make_pair(trace, zero<W>()());
         } else {
             return trace;
         }
     }
-    template<typename W> inline constexpr const trace_t * trace_from(trace_ptr<W> t) {
+    template<typename W> inline constexpr trace_id trace_from(trace_ptr<W> t) {
         if constexpr (is_weighted<W>) {
             return t.first;
         } else {
@@ -106,6 +199,10 @@ namespace pdaaal {
     class PAutomaton {
     public:
         static constexpr auto epsilon = std::numeric_limits<uint32_t>::max();
+        // An edge with this label accepts any label (except epsilon). Used instead of adding an edge per label.
+        // Only the full label set is symbolic: Other label sets (e.g. negated NFA edges with exclusions, or rules with
+        // a list of labels) are still stored as one edge per label.
+        static constexpr auto wildcard = std::numeric_limits<uint32_t>::max() - 2;
 
         struct state_t {
             bool _accepting = false;
@@ -191,7 +288,7 @@ namespace pdaaal {
 
         PAutomaton(PAutomaton &&) noexcept = default;
 
-        PAutomaton(const PAutomaton &other) : _pda(other._pda) {
+        PAutomaton(const PAutomaton &other) : _traces(other._traces), _pda(other._pda) {
             std::unordered_map<state_t *, state_t *> indir;
             for (auto &s : other._states) {
                 _states.emplace_back(std::make_unique<state_t>(*s));
@@ -232,7 +329,11 @@ namespace pdaaal {
                             if (!first)
                                 out << ", ";
                             first = false;
-                            printer(out, l);
+                            if (l == wildcard) {
+                                out << "*";
+                            } else {
+                                printer(out, l);
+                            }
                         }
                         out << "\\]";
                     }
@@ -266,7 +367,7 @@ namespace pdaaal {
                 auto current_state = current.first;
                 auto stack_index = current.second;
                 for (const auto &[to,labels] : _states[current_state]->_edges) {
-                    if (labels.contains(stack[stack_index])) {
+                    if (labels.contains(stack[stack_index]) || labels.contains(wildcard)) {
                         if (stack_index + 1 < stack.size()) {
                             search_stack.emplace(to, stack_index + 1);
                         } else if (_states[to]->_accepting) {
@@ -314,7 +415,7 @@ namespace pdaaal {
                 };
                 struct queue_elem_comp {
                     bool operator()(const queue_elem &lhs, const queue_elem &rhs){
-                        C less;
+                        weight_compare_t<W,C> less;
                         return less(rhs.weight, lhs.weight); // Used in a max-heap, so swap arguments to make it a min-heap.
                     }
                 };
@@ -350,6 +451,10 @@ namespace pdaaal {
                     pointers.push_back(std::move(u_pointer));
                     for (const auto &[to,labels] : _states[current.state]->_edges) {
                         auto label = labels.get(stack[current.stack_index]);
+                        auto wildcard_label = labels.get(wildcard);
+                        if (label == nullptr || (wildcard_label != nullptr && weight_compare_t<W,C>{}(wildcard_label->second, label->second))) {
+                            label = wildcard_label;
+                        }
                         if (label != nullptr) {
                             if (current.stack_index + 1 < stack.size() || _states[to]->_accepting) {
                                 search_queue.emplace(add(current.weight, label->second), to, current.stack_index + 1, pointer);
@@ -377,7 +482,7 @@ namespace pdaaal {
                     auto stack_index = current.second;
                     path[stack_index] = current_state;
                     for (const auto &[to,labels] : _states[current_state]->_edges) {
-                        if (labels.contains(stack[stack_index])) {
+                        if (labels.contains(stack[stack_index]) || labels.contains(wildcard)) {
                             if (stack_index + 1 < stack.size()) {
                                 search_stack.emplace(to, stack_index + 1);
                             } else if (_states[to]->_accepting) {
@@ -395,11 +500,67 @@ namespace pdaaal {
             return get_trace_label(std::get<0>(edge), std::get<1>(edge), std::get<2>(edge));
         }
         [[nodiscard]] const trace_t *get_trace_label(size_t from, uint32_t label, size_t to) const {
+            // A concrete edge is preferred over a wildcard edge. The saturation algorithms only add a concrete edge,
+            // if there is no wildcard edge yet, so the trace found here is never newer than the edges referring to it.
             auto trace = _states[from]->_edges.get(to, label);
-            if (trace) return trace_from<W>(*trace);
+            if (trace) return get_trace(trace_from<W>(*trace));
+            if (label != epsilon) {
+                trace = _states[from]->_edges.get(to, wildcard);
+                if (trace) return get_trace(trace_from<W>(*trace));
+            }
             assert(false); // We assume the edge exists.
             return nullptr;
         }
+        // A concrete label for the edge (from, label, to). For a wildcard edge, this is a label that the rule in its trace
+        // can be applied to, so the trace can be followed from that label. Returns wildcard if the edge has no trace.
+        [[nodiscard]] uint32_t concrete_label(size_t from, uint32_t label, size_t to) const {
+            if (label != wildcard) return label;
+            auto trace_id = _states[from]->_edges.get(to, wildcard);
+            if (!trace_id) return wildcard;
+            const trace_t* trace = get_trace(trace_from<W>(*trace_id));
+            if (trace == nullptr) return wildcard;
+            if (trace->is_post_epsilon_trace()) { // The label comes from the edge (trace->_state, wildcard, to).
+                return concrete_label(trace->_state, wildcard, to);
+            }
+            const auto& [rule, labels] = _pda.states()[trace->is_pre_trace() ? from : trace->_state]._rules[trace->_rule_id];
+            return labels.first_label();
+        }
+        [[nodiscard]] const trace_t *get_trace(trace_id id) const {
+            return id == no_trace ? nullptr : &_traces.get(id);
+        }
+        [[nodiscard]] size_t number_of_traces() const { return _traces.size(); }
+        [[nodiscard]] size_t trace_memory_bytes() const { return _traces.memory_bytes(); }
+        // Approximate memory used by one label on an edge, for estimating the size of the automaton from its number of edges.
+        static constexpr size_t edge_bytes = sizeof(std::tuple<size_t,uint32_t,trace_ptr<W>>);
+
+        // Update the rule ids in the traces of all edges after rules were inserted into the PDA.
+        // rule_map[p][i] is the new id of the rule that had id i in state p. An empty rule_map[p] means that the ids did not change.
+        // pre_traces tells that the traces are from pre* (otherwise from post*).
+        void remap_rule_ids(const std::vector<std::vector<size_t>>& rule_map, bool pre_traces) {
+            auto remap = [&rule_map](size_t state, size_t rule_id) {
+                return state < rule_map.size() && !rule_map[state].empty() ? rule_map[state][rule_id] : rule_id;
+            };
+            if (std::all_of(rule_map.begin(), rule_map.end(), [](const auto& map) { return map.empty(); })) return;
+            for (auto& from : _states) {
+                // The rule of a pre* trace is from the state of the edge, so only edges from states with changed ids need a look.
+                if (pre_traces && (from->_id >= rule_map.size() || rule_map[from->_id].empty())) continue;
+                for (auto& [to,labels] : from->_edges) {
+                    for (auto& [label,trace] : labels) {
+                        auto id = trace_from<W>(trace);
+                        if (id == no_trace) continue;
+                        trace_t t = _traces.get(id);
+                        if (t.is_post_epsilon_trace()) continue;
+                        // The rule of a pre* trace is from the state of the edge, and the rule of a post* trace is from t._state.
+                        t._rule_id = remap(t.is_pre_trace() ? from->_id : t._state, t._rule_id);
+                        if constexpr (is_weighted<W>) {
+                            trace.first = _traces.intern(t);
+                        } else {
+                            trace = _traces.intern(t);
+                        }
+                    }
+                }
+            }
+        }
 
         [[nodiscard]] size_t number_of_labels() const { return _pda.number_of_labels(); }
 
@@ -430,9 +591,30 @@ namespace pdaaal {
             assert(label < std::numeric_limits<uint32_t>::max() - 1);
             _states[from]->_edges.emplace(to, label, trace);
         }
+        void add_wildcard_edge(size_t from, size_t to, trace_ptr<W> trace = default_trace_ptr<W>()) {
+            _states[from]->_edges.emplace(to, wildcard, trace);
+        }
+        // Returns true iff the edge was in the automaton.
+        bool remove_edge(size_t from, size_t to, uint32_t label) {
+            auto& edges = _states[from]->_edges;
+            auto it = edges.find(to);
+            if (it == edges.end() || it->second.erase(label) == 0) {
+                return false;
+            }
+            if (it->second.empty()) {
+                edges.erase(it);
+            }
+            return true;
+        }
+        [[nodiscard]] bool has_wildcard_edge(size_t from, size_t to) const {
+            return _states[from]->_edges.contains(to, wildcard);
+        }
 
+        // With negated and no labels, a single wildcard edge is added. Otherwise an edge is added per label.
         void add_edges(size_t from, size_t to, bool negated, std::vector<uint32_t>&& labels) {
-            if (negated) {
+            if (negated && labels.empty()) {
+                add_wildcard_edge(from, to);
+            } else if (negated) {
                 assert(std::is_sorted(labels.begin(), labels.end()));
                 //std::sort(labels.begin(), labels.end());
                 size_t i = 0;
@@ -453,7 +635,11 @@ namespace pdaaal {
             }
         }
         void add_edges(const std::vector<size_t>& from, size_t to, bool negated, std::vector<uint32_t>&& labels) {
-            if (negated) {
+            if (negated && labels.empty()) {
+                for (auto f : from) {
+                    add_wildcard_edge(f, to);
+                }
+            } else if (negated) {
                 assert(std::is_sorted(labels.begin(), labels.end()));
                 //std::sort(labels.begin(), labels.end());
                 size_t i = 0;
@@ -480,28 +666,24 @@ namespace pdaaal {
             }
         }
 
-        const trace_t *new_pre_trace(size_t rule_id) {
-            _trace_info.emplace_back(std::make_unique<trace_t>(rule_id, std::numeric_limits<size_t>::max()));
-            return _trace_info.back().get();
+        trace_id new_pre_trace(size_t rule_id) {
+            return _traces.intern(trace_t(rule_id, std::numeric_limits<size_t>::max()));
         }
-        const trace_t *new_pre_trace(size_t rule_id, size_t temp_state) {
-            _trace_info.emplace_back(std::make_unique<trace_t>(rule_id, temp_state));
-            return _trace_info.back().get();
+        trace_id new_pre_trace(size_t rule_id, size_t temp_state) {
+            return _traces.intern(trace_t(rule_id, temp_state));
         }
-        const trace_t *new_post_trace(size_t from, size_t rule_id, uint32_t label) {
-            _trace_info.emplace_back(std::make_unique<trace_t>(from, rule_id, label));
-            return _trace_info.back().get();
+        trace_id new_post_trace(size_t from, size_t rule_id, uint32_t label) {
+            return _traces.intern(trace_t(from, rule_id, label));
         }
-        const trace_t *new_post_trace(size_t epsilon_state) {
-            _trace_info.emplace_back(std::make_unique<trace_t>(epsilon_state));
-            return _trace_info.back().get();
+        trace_id new_post_trace(size_t epsilon_state) {
+            return _traces.intern(trace_t(epsilon_state));
         }
     private:
         std::vector<std::unique_ptr<state_t>> _states;
         std::vector<state_t *> _initial;
         std::vector<state_t *> _accepting;
 
-        std::vector<std::unique_ptr<trace_t>> _trace_info;
+        details::trace_arena _traces;
 
         const PDA<W,C> &_pda;
     };
@@ -32,6 +32,7 @@
 #include "fut_set.h"
 
 #include <cinttypes>
+#include <memory>
 #include <vector>
 #include <unordered_set>
 #include <set>
@@ -67,6 +68,11 @@ namespace pdaaal {
             return lb != std::end(_labels) && *lb == label;
         }
 
+        // The smallest label in the (non-empty) set. Any label matches the wildcard, so that gives label 0.
+        [[nodiscard]] uint32_t first_label() const {
+            return _wildcard ? 0 : _labels.front();
+        }
+
         void clear() {
             _wildcard = false;
             _labels.clear();
@@ -228,6 +234,8 @@ namespace pdaaal {
     };
 
 
+    template <typename W, typename C> class CompiledPDA;
+
     template <typename W, typename C, fut::type Container = fut::type::vector>
     class PDA {
     public:
@@ -247,17 +255,19 @@ namespace pdaaal {
                 : _states(std::make_move_iterator(other_pda.states_begin()), std::make_move_iterator(other_pda.states_end())) {}
         PDA() = default;
 
-        auto states_begin() noexcept { return _states.begin(); }
-        auto states_end() noexcept { return _states.end(); }
+        auto states_begin() noexcept { _compiled.reset(); return _states.begin(); }
+        auto states_end() noexcept { _compiled.reset(); return _states.end(); }
 
         [[nodiscard]] virtual size_t number_of_labels() const = 0;
         const std::vector<state_t>& states() const {
             return _states;
         }
         std::vector<state_t>& states_mutable() {
+            _compiled.reset();
             return _states;
         }
         void clear_state(size_t s) {
+            _compiled.reset();
             _states[s]._rules.clear();
             for (auto& p : _states[s]._pre_states) {
                 auto rit = _states[p]._rules.begin();
@@ -290,6 +300,7 @@ namespace pdaaal {
             add_untyped_rule_<W>(std::forward<Args>(args)...);
         }
         void add_untyped_rule_impl(size_t from, rule_t r, bool negated, const std::vector<uint32_t>& pre) {
+            _compiled.reset();
             auto mm = std::max(from, r._to);
             if (mm >= _states.size()) {
                 _states.resize(mm + 1);
@@ -316,6 +327,11 @@ namespace pdaaal {
         }
 
         std::vector<state_t> _states;
+        // Set by compile_pda (see CompiledPDA.h), and reset whenever the rules may change.
+        mutable std::shared_ptr<const CompiledPDA<W,C>> _compiled;
+
+        template <typename W_, typename C_>
+        friend std::shared_ptr<const CompiledPDA<W_,C_>> compile_pda(const PDA<W_,C_>& pda);
     };
 
 }
@@ -30,11 +30,64 @@
 #include "PAutomaton.h"
 #include "TypedPDA.h"
 #include "SolverInstance.h"
+#include "concurrency.h"
+#include "flat_edge_set.h"
+#include "priority_queue.h"
+#include "saturation_stats.h"
+#include "governor.h"
+#include "CompiledPDA.h"
+#include "KShortestTraces.h"
+#include "workset.h"
+#include <chrono>
+#include <numeric>
+#include <type_traits>
+#include <utility>
 
 namespace pdaaal {
 
     namespace details {
         constexpr auto epsilon = std::numeric_limits<uint32_t>::max();
+        constexpr auto wildcard = std::numeric_limits<uint32_t>::max() - 2; // Same as PAutomaton::wildcard
+
+        // Whether an edge with the given label (possibly wildcard) can be used by a rule with the given precondition.
+        // The label that results from combining them is either the label itself or (if label is wildcard) the whole precondition.
+        // Labels is labels_t or labels_view.
+        template <typename Labels>
+        inline bool labels_match(const Labels& precondition, uint32_t label) {
+            return label == wildcard ? !precondition.empty() : precondition.contains(label);
+        }
+
+        // With Trace_Type::None, the saturation algorithms use this instead of allocating a trace for each new edge,
+        // and store no trace in the automaton. (Any trace other than no_trace still marks an edge as new rather than an initial edge.)
+        constexpr trace_id untraced = std::numeric_limits<trace_id>::max();
+        template <Trace_Type trace_type, typename W>
+        inline trace_ptr<W> stored_trace(trace_id trace) {
+            if constexpr (trace_type == Trace_Type::None) {
+                return default_trace_ptr<W>();
+            } else {
+                return trace_ptr_from<W>(trace);
+            }
+        }
+
+        // Creates the trace of a new edge when it is first needed, so a rule application that only finds known edges creates none.
+        // The same trace is then used for all edges added by that application.
+        template <typename Fn>
+        class lazy_trace {
+        public:
+            explicit lazy_trace(Fn fn) : _fn(std::move(fn)) {}
+            trace_id operator()() {
+                if (_trace == no_trace) {
+                    _trace = _fn();
+                }
+                return _trace;
+            }
+        private:
+            Fn _fn;
+            trace_id _trace = no_trace;
+        };
+        inline auto no_new_trace() { // For the edges of the initial automaton.
+            return lazy_trace([]{ return no_trace; });
+        }
 
         struct temp_edge_t {
             size_t _from = std::numeric_limits<size_t>::max();
@@ -73,14 +126,117 @@ namespace pdaaal {
 
         template <typename W>
         using early_termination_fn = std::function<bool(size_t,uint32_t,size_t,trace_ptr<W>)>;
+        // The saturations and solver entry points take the early termination predicate as a template parameter ETFn, so a lambda
+        // is called directly (and can be inlined) for each inserted edge. early_termination_fn is the type-erased fallback and default.
+        template <typename ETFn, typename W>
+        constexpr bool is_early_termination_fn = std::is_invocable_r_v<bool, const ETFn&, size_t, uint32_t, size_t, trace_ptr<W>>;
+
+        // Result of changing the rules of a PDA, used by the incremental saturation.
+        struct rule_changes_t {
+            static constexpr size_t removed_rule = std::numeric_limits<size_t>::max();
+            std::vector<std::vector<size_t>> _rule_map; // _rule_map[p][i] is the new id of rule i of state p, or removed_rule (empty if the ids in p did not change).
+            std::vector<std::pair<size_t,size_t>> _changed; // (p, new rule id) for rules that were added or got new labels.
+            std::vector<std::pair<size_t,size_t>> _removed; // (p, old rule id) for rules that were removed or lost labels.
+            [[nodiscard]] size_t new_rule_id(size_t state, size_t rule_id) const {
+                return _rule_map[state].empty() ? rule_id : _rule_map[state][rule_id];
+            }
+            [[nodiscard]] bool empty() const {
+                return _changed.empty() && _removed.empty();
+            }
+        };
+        // Calls update_rules(), which may add or remove rules between existing states of pda, and returns what changed.
+        // The rules before the update are read from previous (compiled from pda before the update), so they are not copied.
+        template <typename W, typename C, typename Fn>
+        rule_changes_t update_pda_rules(const PDA<W,C>& pda, const CompiledPDA<W,C>& previous, Fn&& update_rules) {
+            const size_t n_states = previous.number_of_states();
+            update_rules();
+            const auto& states = pda.states();
+            if (states.size() != n_states) {
+                throw std::logic_error("Incremental saturation does not support adding PDA states.");
+            }
+            auto is_subset = [](const auto& a, const auto& b) { // a is a subset of b
+                if (b.wildcard()) return true;
+                if (a.wildcard()) return false;
+                return std::includes(b.labels().begin(), b.labels().end(), a.labels().begin(), a.labels().end());
+            };
+            rule_changes_t changes;
+            changes._rule_map.resize(n_states);
+            for (size_t p = 0; p < n_states; ++p) {
+                const auto& rules = states[p]._rules;
+                auto old = previous.rules(p);
+                // Both rule lists are sorted, so we can match them in one pass. The map is only allocated once an id changes.
+                std::vector<size_t> map;
+                auto set_id = [&map, &old](size_t i, size_t j) {
+                    if (map.empty() && i != j) {
+                        map.resize(old.size());
+                        std::iota(map.begin(), map.begin() + i, 0);
+                    }
+                    if (!map.empty()) map[i] = j;
+                };
+                size_t i = 0, j = 0;
+                while (i < old.size() || j < rules.size()) {
+                    if (j == rules.size() || (i < old.size() && old[i].first < rules[j].first)) {
+                        changes._removed.emplace_back(p, i);
+                        set_id(i, rule_changes_t::removed_rule);
+                        ++i;
+                    } else if (i == old.size() || rules[j].first < old[i].first) {
+                        changes._changed.emplace_back(p, j);
+                        ++j;
+                    } else {
+                        const auto& old_labels = old[i].second;
+                        const auto& labels = rules[j].second;
+                        if (!is_subset(labels, old_labels)) {
+                            changes._changed.emplace_back(p, j);
+                        }
+                        if (!is_subset(old_labels, labels)) {
+                            changes._removed.emplace_back(p, i);
+                        }
+                        set_id(i, j);
+                        ++i; ++j;
+                    }
+                }
+                changes._rule_map[p] = std::move(map);
+            }
+            return changes;
+        }
+
+        // Check that compiled was made from pda, or use the compiled PDA cached in pda if compiled is null.
+        template <typename W, typename C>
+        std::shared_ptr<const CompiledPDA<W,C>> compiled_pda(const PDA<W,C>& pda, std::shared_ptr<const CompiledPDA<W,C>> compiled) {
+            if (!compiled) {
+                return compile_pda(pda);
+            }
+            if (!compiled->matches(pda)) {
+                throw std::logic_error("The compiled PDA does not match the PDA of the automaton.");
+            }
+            assert(compiled->same_rules(pda));
+            return compiled;
+        }
+
+        // Expected number of edges in the saturated automaton, used to pre-size the edge set: The edges of the initial automaton plus one per rule.
+        template <typename W, typename C, typename A>
+        size_t expected_edges(const PAutomaton<W,C,A>& automaton, const CompiledPDA<W,C>& pda) {
+            size_t n_edges = pda.number_of_rules();
+            for (const auto& state : automaton.states()) {
+                for (const auto& [to, labels] : state->_edges) {
+                    n_edges += labels.size();
+                }
+            }
+            return n_edges;
+        }
 
-        template <typename W, typename C, typename A, bool ET=false>
+        // With Stats=true, the saturation counts its work in a saturation_stats (see stats()).
+        // The rules are read from a CompiledPDA, which is compiled from the PDA of the automaton unless one is given.
+        // Workset is the workset policy (see workset.h), which decides the order edges are processed in.
+        template <typename W, typename C, typename A, bool ET=false, Trace_Type trace_type = Trace_Type::Any, bool Stats=false,
+                  typename ETFn = early_termination_fn<W>, template<typename> class Workset = lifo_workset>
         class PreStarSaturation {
         public:
-            explicit PreStarSaturation(PAutomaton<W,C,A> &automaton, const early_termination_fn<W>& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; })
-                    : _automaton(automaton), _early_termination(early_termination), _pda_states(_automaton.pda().states()),
-                      _n_pda_states(_pda_states.size()), _n_automaton_states(_automaton.states().size()),
-                      _n_pda_labels(_automaton.number_of_labels()), _rel(_n_automaton_states), _delta_prime(_n_automaton_states) {
+            explicit PreStarSaturation(PAutomaton<W,C,A> &automaton, const ETFn& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; },
+                                       std::shared_ptr<const CompiledPDA<W,C>> compiled = nullptr, Workset<temp_edge_t> workset = Workset<temp_edge_t>())
+                    : _automaton(automaton), _early_termination(early_termination), _pda(compiled_pda(_automaton.pda(), std::move(compiled))),
+                      _n_pda_states(_pda->number_of_states()), _n_automaton_states(_automaton.states().size()),
+                      _workset(std::move(workset)), _rel(_n_automaton_states), _delta_prime(_n_automaton_states) {
                 initialize();
             };
 
@@ -90,67 +246,99 @@ namespace pdaaal {
             // http://www.lsv.fr/Publis/PAPERS/PDF/schwoon-phd02.pdf (page 42)
 
             PAutomaton<W,C,A>& _automaton;
-            const early_termination_fn<W>& _early_termination;
-            const std::vector<typename PDA<W,C>::state_t>& _pda_states;
+            const ETFn& _early_termination;
+            std::shared_ptr<const CompiledPDA<W,C>> _pda;
             const size_t _n_pda_states;
             const size_t _n_automaton_states;
-            const size_t _n_pda_labels;
-            std::unordered_set<temp_edge_t, temp_edge_hasher> _edges;
-            std::stack<temp_edge_t> _workset;
+            flat_edge_set _edges;
+            Workset<temp_edge_t> _workset;
             std::vector<std::vector<std::pair<size_t,uint32_t>>> _rel;
             std::vector<std::vector<std::pair<size_t, size_t>>> _delta_prime;
             bool _found = false;
+            std::mutex* _automaton_lock = nullptr;
+            stats_recorder<Stats> _stats;
 
             void initialize() {
+                _edges.reserve(expected_edges(_automaton, *_pda));
                 // workset := ->_0  (line 1)
                 for (const auto &from : _automaton.states()) {
                     for (const auto &[to,labels] : from->_edges) {
                         for (const auto &[label,_] : labels) {
-                            insert_edge(from->_id, label, to, nullptr);
+                            insert_edge(from->_id, label, to, no_trace);
                         }
                     }
                 }
 
                 // for all <p, y> --> <p', epsilon> : workset U= (p, y, p') (line 2)
-                for (size_t state = 0; state < _n_pda_states; ++state) {
-                    size_t rule_id = 0;
-                    for (const auto&[rule,labels] : _pda_states[state]._rules) {
-                        if (rule._operation == POP) {
-                            insert_edge_bulk(state, labels, rule._to, _automaton.new_pre_trace(rule_id));
-                        }
-                        ++rule_id;
+                for (size_t to = 0; to < _n_pda_states; ++to) {
+                    for (auto [state, rule_id] : _pda->rules_into(to, POP)) {
+                        insert_edge_bulk(state, _pda->rules(state)[rule_id].second, to, new_pre_trace(rule_id));
                     }
                 }
             }
-            void insert_edge(size_t from, uint32_t label, size_t to, const trace_t *trace) {
-                auto res = _edges.emplace(from, label, to);
-                if (res.second) { // New edge is not already in edges (rel U workset).
-                    _workset.emplace(from, label, to);
-                    if (trace != nullptr) { // Don't add existing edges
+            // Held while adding an edge to the automaton and calling early termination, if another thread reads the automaton.
+            std::unique_lock<std::mutex> lock_automaton() {
+                return _automaton_lock == nullptr ? std::unique_lock<std::mutex>() : std::unique_lock<std::mutex>(*_automaton_lock);
+            }
+            trace_id new_pre_trace(size_t rule_id) {
+                if constexpr (trace_type == Trace_Type::None) {
+                    return untraced;
+                } else {
+                    _stats.trace();
+                    return _automaton.new_pre_trace(rule_id);
+                }
+            }
+            trace_id new_pre_trace(size_t rule_id, size_t temp_state) {
+                if constexpr (trace_type == Trace_Type::None) {
+                    return untraced;
+                } else {
+                    _stats.trace();
+                    return _automaton.new_pre_trace(rule_id, temp_state);
+                }
+            }
+            void insert_edge(size_t from, uint32_t label, size_t to, trace_id trace) {
+                if (label != wildcard && _edges.contains(from, wildcard, to)) { // Subsumed by the wildcard edge.
+                    _stats.duplicate_edge();
+                    return;
+                }
+                if (_edges.emplace(from, label, to)) { // New edge is not already in edges (rel U workset).
+                    _workset.push(temp_edge_t{from, label, to});
+                    _stats.edge_inserted();
+                    _stats.workset_size(_workset.size());
+                    if (trace != no_trace) { // Don't add existing edges
+                        auto guard = lock_automaton();
                         if constexpr (ET) {
-                            _found = _found || _early_termination(from, label, to, trace_ptr_from<W>(trace));
+                            _found = _found || _early_termination(from, label, to, stored_trace<trace_type,W>(trace));
                         }
-                        _automaton.add_edge(from, to, label, trace_ptr_from<W>(trace));
+                        _automaton.add_edge(from, to, label, stored_trace<trace_type,W>(trace));
                     }
+                } else {
+                    _stats.duplicate_edge();
                 }
             };
-            void insert_edge_bulk(size_t from, const labels_t &precondition, size_t to, const trace_t *trace) {
+            void insert_edge_bulk(size_t from, const labels_view &precondition, size_t to, trace_id trace) {
                 if (precondition.wildcard()) {
-                    for (uint32_t i = 0; i < _n_pda_labels; i++) {
-                        insert_edge(from, i, to, trace);
-                    }
+                    insert_edge(from, wildcard, to, trace);
                 } else {
                     for (auto &label : precondition.labels()) {
                         insert_edge(from, label, to, trace);
                     }
                 }
             };
+            // Insert edge(s) for the labels in precondition that match label (see labels_match).
+            void insert_edge_match(size_t from, const labels_view &precondition, uint32_t label, size_t to, trace_id trace) {
+                if (label == wildcard) {
+                    insert_edge_bulk(from, precondition, to, trace);
+                } else {
+                    insert_edge(from, label, to, trace);
+                }
+            }
 
         public:
             void step() {
                 // pop t = (q, y, q') from workset (line 4)
-                auto t = _workset.top();
-                _workset.pop();
+                auto t = _workset.pop();
+                _stats.step();
                 // rel = rel U {t} (line 6)   (membership test on line 5 is done in insert_edge).
                 _rel[t._from].emplace_back(t._to, t._label);
 
@@ -158,41 +346,273 @@ namespace pdaaal {
                 for (auto pair : _delta_prime[t._from]) { // Loop over delta_prime (that match with t->from)
                     auto state = pair.first;
                     auto rule_id = pair.second;
-                    if (_pda_states[state]._rules[rule_id].second.contains(t._label)) {
-                        insert_edge(state, t._label, t._to, _automaton.new_pre_trace(rule_id, t._from));
+                    auto labels = _pda->rules(state)[rule_id].second;
+                    _stats.rule_scanned();
+                    if (labels_match(labels, t._label)) {
+                        _stats.rule_matched();
+                        insert_edge_match(state, labels, t._label, t._to, new_pre_trace(rule_id, t._from));
                     }
                 }
-                // Loop over \Delta (filter rules going into q) (line 7 and 9)
+                // Loop over \Delta (rules going into q) (line 7 and 9). Pop rules were applied in initialize.
                 if (t._from >= _n_pda_states) { return; }
-                for (auto pre_state : _pda_states[t._from]._pre_states) {
-                    const auto &rules = _pda_states[pre_state]._rules;
-                    auto lb = rules.lower_bound(details::rule_t<W,C>{t._from});
-                    while (lb != rules.end() && lb->first._to == t._from) {
-                        const auto &[rule, labels] = *lb;
-                        size_t rule_id = lb - rules.begin();
-                        ++lb;
+                for (auto operation : {SWAP, NOOP, PUSH}) {
+                    for (auto [pre_state, rule_id] : _pda->rules_into(t._from, operation)) {
+                        apply_rule(t, pre_state, rule_id);
+                    }
+                }
+            }
+            [[nodiscard]] bool workset_empty() const {
+                return _workset.empty();
+            }
+            [[nodiscard]] size_t workset_size() const {
+                return _workset.size();
+            }
+            [[nodiscard]] size_t number_of_edges() const { // Edges found so far (rel U workset).
+                return _edges.size();
+            }
+            [[nodiscard]] bool found() const {
+                return _found;
+            }
+            [[nodiscard]] saturation_stats stats() const {
+                return _stats.get();
+            }
+            // Estimate of the memory used by the edges found so far (in the automaton and in the saturation) and the traces.
+            [[nodiscard]] size_t memory_bytes() const {
+                return _edges.memory_bytes() + _edges.size() * PAutomaton<W,C,A>::edge_bytes + _automaton.trace_memory_bytes();
+            }
+            // Use lock when adding edges to the automaton, so another thread can read the automaton (e.g. in early termination).
+            void set_automaton_lock(std::mutex* lock) {
+                _automaton_lock = lock;
+            }
+            // Saturate until the workset is empty or (if ET) early termination is reached.
+            void run() {
+                while (!_workset.empty()) {
+                    if constexpr (ET) {
+                        if (_found) return;
+                    }
+                    step();
+                }
+            }
+
+            // Incremental saturation: add_rules() may add rules between existing states to the PDA of the automaton.
+            // pre* is monotone in the rules, so we keep the current edges, apply the new rules (and new labels of existing rules)
+            // to the processed edges, and continue to the new fixpoint. Rule ids in existing traces are updated to the new numbering.
+            template <typename Fn>
+            void add_rules(Fn&& add_rules) {
+                auto changes = update_pda_rules(_automaton.pda(), *_pda, std::forward<Fn>(add_rules));
+                if (!changes._removed.empty()) {
+                    throw std::logic_error("Use remove_rules to remove rules from the PDA during incremental pre*.");
+                }
+                if (changes.empty()) return;
+                _pda = std::make_shared<const CompiledPDA<W,C>>(_automaton.pda(), *_pda);
+                remap_rule_ids(changes);
+                apply_changed_rules(changes);
+                run();
+            }
+
+            // Incremental saturation: update_rules() may remove (and add) rules between existing states of the PDA.
+            // This uses the DRed approach (delete and rederive): First over-delete the edges whose trace uses a removed rule
+            // or (transitively) an edge that was deleted. Then rederive the deleted edges that can still be derived in one step
+            // from the remaining edges, and continue the saturation from these.
+            template <typename Fn>
+            void remove_rules(Fn&& update_rules) {
+                static_assert(trace_type != Trace_Type::None, "Removing rules requires traces to find the edges that depend on a removed rule.");
+                auto changes = update_pda_rules(_automaton.pda(), *_pda, std::forward<Fn>(update_rules));
+                if (changes.empty()) return;
+                _pda = std::make_shared<const CompiledPDA<W,C>>(_automaton.pda(), *_pda);
+                auto deleted = over_delete(changes);
+                remap_rule_ids(changes);
+                rederive(deleted);
+                apply_changed_rules(changes);
+                run();
+            }
+
+        private:
+            void remap_rule_ids(const rule_changes_t& changes) {
+                for (auto& delta_prime : _delta_prime) {
+                    for (auto& [state, rule_id] : delta_prime) {
+                        rule_id = changes.new_rule_id(state, rule_id);
+                    }
+                }
+                _automaton.remap_rule_ids(changes._rule_map, true);
+            }
+
+            // Apply the new rules (and new labels of existing rules) to the processed edges.
+            void apply_changed_rules(const rule_changes_t& changes) {
+                for (auto [state, rule_id] : changes._changed) {
+                    auto [rule, labels] = _pda->rules(state)[rule_id];
+                    if (rule._operation == POP) { // (line 2)
+                        insert_edge_bulk(state, labels, rule._to, new_pre_trace(rule_id));
+                    } else {
+                        for (auto [to, label] : _rel[rule._to]) {
+                            apply_rule(temp_edge_t{rule._to, label, to}, state, rule_id);
+                        }
+                    }
+                }
+            }
+
+            // Remove the edges that depend on a removed rule from the automaton and the saturation state, and return them.
+            // Rule ids in traces and _delta_prime must still be the old ones.
+            // Only the edges from states with removed rules, and then the edges that can depend on a deleted edge, are visited.
+            std::vector<temp_edge_t> over_delete(const rule_changes_t& changes) {
+                std::vector<temp_edge_t> deleted;
+                flat_edge_set deleted_set;
+                auto delete_edge = [&deleted, &deleted_set](size_t from, uint32_t label, size_t to) {
+                    if (deleted_set.emplace(from, label, to)) {
+                        deleted.push_back(temp_edge_t{from, label, to});
+                    }
+                };
+                // The current rule id of the trace of an edge from state from, or removed_rule for initial edges and removed rules.
+                auto rule_of = [this, &changes](size_t from, const auto& trace) -> std::pair<size_t, const trace_t*> {
+                    auto id = trace_from<W>(trace);
+                    if (id == no_trace) return {rule_changes_t::removed_rule, nullptr}; // Edges in the initial automaton are never deleted.
+                    const auto* t = _automaton.get_trace(id);
+                    return {changes.new_rule_id(from, t->_rule_id), t};
+                };
+
+                // The rule of a pre* trace is from the state of the edge, so the edges using a removed rule are among the edges from its state.
+                std::unordered_set<std::pair<size_t,size_t>, boost::hash<std::pair<size_t,size_t>>> removed(changes._removed.begin(), changes._removed.end());
+                std::vector<size_t> removed_states;
+                for (auto [from, rule_id] : changes._removed) {
+                    removed_states.push_back(from);
+                }
+                std::sort(removed_states.begin(), removed_states.end());
+                removed_states.erase(std::unique(removed_states.begin(), removed_states.end()), removed_states.end());
+                for (auto from : removed_states) {
+                    for (const auto& [to, labels] : _automaton.states()[from]->_edges) {
+                        for (const auto& [label, trace] : labels) {
+                            auto id = trace_from<W>(trace);
+                            if (id != no_trace && removed.count(std::make_pair(from, _automaton.get_trace(id)->_rule_id)) > 0) {
+                                delete_edge(from, label, to);
+                            }
+                        }
+                    }
+                }
+
+                // The trace of an edge (p, y, q) uses the rule <p, y> -> <p', w> and the path p' -w-> q in the automaton.
+                // The path uses either the label in w or a wildcard edge, so the edge depends on both.
+                // A deleted edge (f, l, t) is on such a path either as the first edge (then p' = f, and we look at the rules into f),
+                // or as the second edge of a push rule (then the edge is (p, l, t) or (p, y, t) if l is a wildcard, for p with a push rule).
+                std::vector<size_t> push_states;
+                for (size_t to = 0; to < _n_pda_states; ++to) {
+                    for (auto [state, rule_id] : _pda->rules_into(to, PUSH)) {
+                        push_states.push_back(state);
+                    }
+                }
+                std::sort(push_states.begin(), push_states.end());
+                push_states.erase(std::unique(push_states.begin(), push_states.end()), push_states.end());
+                auto label_matches = [](uint32_t deleted_label, uint32_t label) { return deleted_label == label || deleted_label == wildcard; };
+                for (size_t i = 0; i < deleted.size(); ++i) {
+                    auto d = deleted[i];
+                    if (d._from < _n_pda_states) {
+                        for (auto operation : {SWAP, NOOP, PUSH}) {
+                            for (auto [p, rule_id] : _pda->rules_into(d._from, operation)) {
+                                const auto& rule = _pda->rules(p)[rule_id].first;
+                                const auto& edges = _automaton.states()[p]->_edges;
+                                if (operation == PUSH) {
+                                    if (!label_matches(d._label, rule._op_label)) continue;
+                                    for (const auto& [to, labels] : edges) {
+                                        for (const auto& [label, trace] : labels) {
+                                            auto [trace_rule, t] = rule_of(p, trace);
+                                            if (trace_rule == rule_id && t->_state == d._to) delete_edge(p, label, to);
+                                        }
+                                    }
+                                    continue;
+                                }
+                                if (operation == SWAP && !label_matches(d._label, rule._op_label)) continue;
+                                auto it = edges.find(d._to);
+                                if (it == edges.end()) continue;
+                                for (const auto& [label, trace] : it->second) {
+                                    if (operation == NOOP && !label_matches(d._label, label)) continue;
+                                    if (rule_of(p, trace).first == rule_id) delete_edge(p, label, d._to);
+                                }
+                            }
+                        }
+                    }
+                    for (auto p : push_states) {
+                        const auto& edges = _automaton.states()[p]->_edges;
+                        auto it = edges.find(d._to);
+                        if (it == edges.end()) continue;
+                        for (const auto& [label, trace] : it->second) {
+                            if (!label_matches(d._label, label)) continue;
+                            auto [trace_rule, t] = rule_of(p, trace);
+                            if (trace_rule != rule_changes_t::removed_rule && t->_state == d._from
+                                && _pda->rules(p)[trace_rule].first._operation == PUSH) {
+                                delete_edge(p, label, d._to);
+                            }
+                        }
+                    }
+                }
+                std::vector<bool> affected(_n_automaton_states, false);
+                for (const auto& edge : deleted) {
+                    _edges.erase(edge._from, edge._label, edge._to);
+                    _automaton.remove_edge(edge._from, edge._to, edge._label);
+                    affected[edge._from] = true;
+                }
+                for (size_t from = 0; from < _n_automaton_states; ++from) {
+                    if (!affected[from]) continue;
+                    auto& rel = _rel[from];
+                    rel.erase(std::remove_if(rel.begin(), rel.end(), [&deleted_set, from](const auto& pair) {
+                        return deleted_set.contains(from, pair.second, pair.first);
+                    }), rel.end());
+                }
+                std::vector<temp_edge_t> workset;
+                while (!_workset.empty()) {
+                    workset.push_back(_workset.pop());
+                }
+                for (auto it = workset.rbegin(); it != workset.rend(); ++it) {
+                    if (!deleted_set.contains(it->_from, it->_label, it->_to)) {
+                        _workset.push(*it);
+                    }
+                }
+                // An entry (p, rule) in _delta_prime[q] stems from an edge (p', y', q) for the rule <p, y> -> <p', y' y''>.
+                std::vector<bool> affected_to(_n_automaton_states, false);
+                for (const auto& edge : deleted) {
+                    affected_to[edge._to] = true;
+                }
+                for (size_t q = 0; q < _n_automaton_states; ++q) {
+                    auto& delta_prime = _delta_prime[q];
+                    delta_prime.erase(std::remove_if(delta_prime.begin(), delta_prime.end(), [&](const auto& pair) {
+                        auto rule_id = changes.new_rule_id(pair.first, pair.second);
+                        if (rule_id == rule_changes_t::removed_rule) return true;
+                        if (!affected_to[q]) return false; // The edge (p', y', q) is still there.
+                        const auto& rule = _pda->rules(pair.first)[rule_id].first;
+                        return !_edges.contains(rule._to, rule._op_label, q) && !_edges.contains(rule._to, wildcard, q);
+                    }), delta_prime.end());
+                }
+                return deleted;
+            }
+
+            // Insert the deleted edges (and other edges between the same states) that can be derived in one step from the remaining edges.
+            void rederive(const std::vector<temp_edge_t>& deleted) {
+                std::set<std::pair<size_t,size_t>> pairs;
+                for (const auto& edge : deleted) {
+                    pairs.emplace(edge._from, edge._to);
+                }
+                for (auto [from, to] : pairs) {
+                    auto rules = _pda->rules(from);
+                    for (size_t rule_id = 0; rule_id < rules.size(); ++rule_id) {
+                        auto [rule, labels] = rules[rule_id];
                         switch (rule._operation) {
                             case POP:
-                                break;
-                            case SWAP: // (line 7-8 for \Delta)
-                                if (rule._op_label == t._label) {
-                                    insert_edge_bulk(pre_state, labels, t._to, _automaton.new_pre_trace(rule_id));
+                                if (rule._to == to) {
+                                    insert_edge_bulk(from, labels, to, new_pre_trace(rule_id));
                                 }
                                 break;
-                            case NOOP: // (line 7-8 for \Delta)
-                                if (labels.contains(t._label)) {
-                                    insert_edge(pre_state, t._label, t._to, _automaton.new_pre_trace(rule_id));
+                            case SWAP:
+                            case NOOP:
+                                for (auto [rel_to, label] : _rel[rule._to]) {
+                                    if (rel_to == to) {
+                                        apply_rule(temp_edge_t{rule._to, label, rel_to}, from, rule_id);
+                                    }
                                 }
                                 break;
-                            case PUSH: // (line 9)
-                                if (rule._op_label == t._label) {
-                                    // (line 10)
-                                    _delta_prime[t._to].emplace_back(pre_state, rule_id);
-                                    const trace_t *trace = nullptr;
-                                    for (auto rel_rule : _rel[t._to]) { // (line 11-12)
-                                        if (labels.contains(rel_rule.second)) {
-                                            trace = trace == nullptr ? _automaton.new_pre_trace(rule_id, t._to) : trace;
-                                            insert_edge(pre_state, rel_rule.second, rel_rule.first, trace);
+                            case PUSH:
+                                for (auto [mid, label] : _rel[rule._to]) {
+                                    if (label != rule._op_label && label != wildcard) continue;
+                                    for (auto [rel_to, rel_label] : _rel[mid]) {
+                                        if (rel_to == to && labels_match(labels, rel_label)) {
+                                            insert_edge_match(from, labels, rel_label, to, new_pre_trace(rule_id, mid));
                                         }
                                     }
                                 }
@@ -203,20 +623,269 @@ namespace pdaaal {
                     }
                 }
             }
-            [[nodiscard]] bool workset_empty() const {
-                return _workset.empty();
+
+            // Line 7-12 for rule number rule_id from pre_state applied to the processed edge t.
+            void apply_rule(const temp_edge_t& t, size_t pre_state, size_t rule_id) {
+                auto [rule, labels] = _pda->rules(pre_state)[rule_id];
+                _stats.rule_scanned();
+                switch (rule._operation) {
+                    case POP:
+                        break;
+                    case SWAP: // (line 7-8 for \Delta)
+                        if (rule._op_label == t._label || t._label == wildcard) {
+                            _stats.rule_matched();
+                            insert_edge_bulk(pre_state, labels, t._to, new_pre_trace(rule_id));
+                        }
+                        break;
+                    case NOOP: // (line 7-8 for \Delta)
+                        if (labels_match(labels, t._label)) {
+                            _stats.rule_matched();
+                            insert_edge_match(pre_state, labels, t._label, t._to, new_pre_trace(rule_id));
+                        }
+                        break;
+                    case PUSH: // (line 9)
+                        if (rule._op_label == t._label || t._label == wildcard) {
+                            _stats.rule_matched();
+                            // (line 10)
+                            _delta_prime[t._to].emplace_back(pre_state, rule_id);
+                            trace_id trace = no_trace;
+                            for (auto rel_rule : _rel[t._to]) { // (line 11-12)
+                                if (labels_match(labels, rel_rule.second)) {
+                                    trace = trace == no_trace ? new_pre_trace(rule_id, t._to) : trace;
+                                    insert_edge_match(pre_state, labels, rel_rule.second, rel_rule.first, trace);
+                                }
+                            }
+                        }
+                        break;
+                    default:
+                        assert(false);
+                }
+            }
+        };
+
+        // Multi-threaded version of PreStarSaturation. Each thread has its own workset and steals from the others when it runs empty.
+        // The resulting automaton accepts the same labels on each (from, to) pair as with PreStarSaturation, but the trace found for each edge may differ,
+        // and a concrete edge that is subsumed by a wildcard edge may or may not be present.
+        template <typename W, typename C, typename A, bool ET=false, Trace_Type trace_type = Trace_Type::Any, typename ETFn = early_termination_fn<W>>
+        class ParallelPreStarSaturation {
+        public:
+            ParallelPreStarSaturation(PAutomaton<W,C,A> &automaton, size_t n_threads, ETFn early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; },
+                                      std::shared_ptr<const CompiledPDA<W,C>> compiled = nullptr)
+                    : _automaton(automaton), _early_termination(std::move(early_termination)), _pda(compiled_pda(_automaton.pda(), std::move(compiled))),
+                      _n_pda_states(_pda->number_of_states()), _n_automaton_states(_automaton.states().size()),
+                      _n_threads(std::max<size_t>(n_threads, 1)),
+                      _edges(_n_threads * 16), _workset(_n_threads), _rel_locks(_n_threads * 16),
+                      _automaton_locks(ET ? 1 : _n_threads * 16), _rel(_n_automaton_states), _delta_prime(_n_automaton_states) {
+                initialize();
+            };
+
+            // Saturate until the worksets are empty or (if ET) early termination is reached.
+            void run() {
+                if constexpr (ET) {
+                    if (found()) return;
+                }
+                run_threads(_n_threads, [this](size_t thread){ work(thread); });
             }
             [[nodiscard]] bool found() const {
-                return _found;
+                return _found.load(std::memory_order_relaxed);
+            }
+
+        private:
+            // This parallelizes Algorithm 1 (figure 3.3) in:
+            // Schwoon, Stefan. Model-checking pushdown systems. 2002. PhD Thesis. Technische Universität München.
+            // http://www.lsv.fr/Publis/PAPERS/PDF/schwoon-phd02.pdf (page 42)
+            // Line 10-12 pairs an entry in _delta_prime[q] with the entries in _rel[q]. Appending to one of these and reading the other
+            // is done in the same critical section (per q), so for each pair, the thread adding the last of the two sees the other.
+
+            PAutomaton<W,C,A>& _automaton;
+            ETFn _early_termination;
+            std::shared_ptr<const CompiledPDA<W,C>> _pda;
+            const size_t _n_pda_states;
+            const size_t _n_automaton_states;
+            const size_t _n_threads;
+            concurrent_set<temp_edge_t, temp_edge_hasher> _edges;
+            work_stealing_workset<temp_edge_t> _workset;
+            striped_mutex _rel_locks; // Guards _rel[q] and _delta_prime[q].
+            striped_mutex _automaton_locks; // Guards edges from a state in _automaton. With ET, a single lock also serializes _early_termination.
+            std::mutex _trace_lock;
+            std::vector<std::vector<std::pair<size_t,uint32_t>>> _rel;
+            std::vector<std::vector<std::pair<size_t, size_t>>> _delta_prime;
+            std::atomic<bool> _found = false;
+
+            void initialize() {
+                // workset := ->_0  (line 1)
+                size_t thread = 0;
+                for (const auto &from : _automaton.states()) {
+                    for (const auto &[to,labels] : from->_edges) {
+                        for (const auto &[label,_] : labels) {
+                            auto trace = no_new_trace();
+                            insert_edge(thread, from->_id, label, to, trace);
+                            thread = (thread + 1) % _n_threads;
+                        }
+                    }
+                }
+                // for all <p, y> --> <p', epsilon> : workset U= (p, y, p') (line 2)
+                for (size_t to = 0; to < _n_pda_states; ++to) {
+                    for (auto [state, rule_id] : _pda->rules_into(to, POP)) {
+                        lazy_trace trace([this, rule_id = rule_id]{ return new_pre_trace(rule_id); });
+                        insert_edge_bulk(thread, state, _pda->rules(state)[rule_id].second, to, trace);
+                        thread = (thread + 1) % _n_threads;
+                    }
+                }
+            }
+
+            trace_id new_pre_trace(size_t rule_id) {
+                if constexpr (trace_type == Trace_Type::None) {
+                    return untraced;
+                } else {
+                    std::lock_guard<std::mutex> guard(_trace_lock);
+                    return _automaton.new_pre_trace(rule_id);
+                }
+            }
+            trace_id new_pre_trace(size_t rule_id, size_t temp_state) {
+                if constexpr (trace_type == Trace_Type::None) {
+                    return untraced;
+                } else {
+                    std::lock_guard<std::mutex> guard(_trace_lock);
+                    return _automaton.new_pre_trace(rule_id, temp_state);
+                }
+            }
+
+            // The trace is only created (by make_trace) if the edge is new.
+            template <typename TraceFn>
+            void insert_edge(size_t thread, size_t from, uint32_t label, size_t to, TraceFn& make_trace) {
+                if (label != wildcard && _edges.contains(temp_edge_t{from, wildcard, to})) return; // Subsumed by the wildcard edge.
+                if (_edges.insert(temp_edge_t{from, label, to})) { // New edge is not already in edges (rel U workset).
+                    _workset.emplace(thread, from, label, to);
+                    auto trace = make_trace();
+                    if (trace != no_trace) { // Don't add existing edges
+                        std::lock_guard<std::mutex> guard(_automaton_locks[from]);
+                        // The wildcard edge may have been added since the check above. Then don't store a newer concrete edge.
+                        if (label != wildcard && _automaton.has_wildcard_edge(from, to)) return;
+                        if constexpr (ET) {
+                            if (!found() && _early_termination(from, label, to, stored_trace<trace_type,W>(trace))) {
+                                _found.store(true, std::memory_order_relaxed);
+                                _workset.stop(); // Wake up idle workers, so they see that we are done.
+                            }
+                        }
+                        _automaton.add_edge(from, to, label, stored_trace<trace_type,W>(trace));
+                    }
+                }
+            }
+            template <typename TraceFn>
+            void insert_edge_bulk(size_t thread, size_t from, const labels_view &precondition, size_t to, TraceFn& trace) {
+                if (precondition.wildcard()) {
+                    insert_edge(thread, from, wildcard, to, trace);
+                } else {
+                    for (auto &label : precondition.labels()) {
+                        insert_edge(thread, from, label, to, trace);
+                    }
+                }
+            }
+            template <typename TraceFn>
+            void insert_edge_match(size_t thread, size_t from, const labels_view &precondition, uint32_t label, size_t to, TraceFn& trace) {
+                if (label == wildcard) {
+                    insert_edge_bulk(thread, from, precondition, to, trace);
+                } else {
+                    insert_edge(thread, from, label, to, trace);
+                }
+            }
+
+            void work(size_t thread) {
+                temp_edge_t t;
+                while (true) {
+                    if constexpr (ET) {
+                        if (found()) return;
+                    }
+                    if (_workset.pop(thread, t)) {
+                        step(thread, t);
+                        _workset.done();
+                    } else if (_workset.finished()) {
+                        return;
+                    } else {
+                        _workset.wait();
+                    }
+                }
+            }
+
+            void step(size_t thread, const temp_edge_t& t) {
+                // rel = rel U {t} (line 6)   (membership test on line 5 is done in insert_edge).
+                size_t n_delta_prime;
+                {
+                    std::lock_guard<std::mutex> guard(_rel_locks[t._from]);
+                    _rel[t._from].emplace_back(t._to, t._label);
+                    n_delta_prime = _delta_prime[t._from].size();
+                }
+                // (line 7-8 for \Delta')
+                for_each_prefix(_rel_locks[t._from], _delta_prime[t._from], n_delta_prime, [this, thread, &t](std::pair<size_t,size_t> pair) {
+                    auto [state, rule_id] = pair;
+                    auto labels = _pda->rules(state)[rule_id].second;
+                    if (labels_match(labels, t._label)) {
+                        lazy_trace trace([this, rule_id = rule_id, &t]{ return new_pre_trace(rule_id, t._from); });
+                        insert_edge_match(thread, state, labels, t._label, t._to, trace);
+                    }
+                });
+                // Loop over \Delta (rules going into q) (line 7 and 9). Pop rules were applied in initialize.
+                if (t._from >= _n_pda_states) { return; }
+                for (auto operation : {SWAP, NOOP, PUSH}) {
+                    for (auto [pre_state, rule_id] : _pda->rules_into(t._from, operation)) {
+                        apply_rule(thread, t, pre_state, rule_id);
+                    }
+                }
+            }
+
+            // Line 7-12 for rule number rule_id from pre_state applied to the processed edge t.
+            void apply_rule(size_t thread, const temp_edge_t& t, size_t pre_state, size_t rule_id) {
+                auto rule_labels = _pda->rules(pre_state)[rule_id];
+                const auto& rule = rule_labels.first;
+                const auto& labels = rule_labels.second; // Not a structured binding, since the lambda below captures it.
+                switch (rule._operation) {
+                    case POP:
+                        break;
+                    case SWAP: // (line 7-8 for \Delta)
+                        if (rule._op_label == t._label || t._label == wildcard) {
+                            lazy_trace trace([this, rule_id]{ return new_pre_trace(rule_id); });
+                            insert_edge_bulk(thread, pre_state, labels, t._to, trace);
+                        }
+                        break;
+                    case NOOP: // (line 7-8 for \Delta)
+                        if (labels_match(labels, t._label)) {
+                            lazy_trace trace([this, rule_id]{ return new_pre_trace(rule_id); });
+                            insert_edge_match(thread, pre_state, labels, t._label, t._to, trace);
+                        }
+                        break;
+                    case PUSH: // (line 9)
+                        if (rule._op_label == t._label || t._label == wildcard) {
+                            size_t n_rel;
+                            {
+                                std::lock_guard<std::mutex> guard(_rel_locks[t._to]);
+                                _delta_prime[t._to].emplace_back(pre_state, rule_id); // (line 10)
+                                n_rel = _rel[t._to].size();
+                            }
+                            lazy_trace trace([this, rule_id, &t]{ return new_pre_trace(rule_id, t._to); });
+                            for_each_prefix(_rel_locks[t._to], _rel[t._to], n_rel, [&](std::pair<size_t,uint32_t> rel_rule) { // (line 11-12)
+                                if (labels_match(labels, rel_rule.second)) {
+                                    insert_edge_match(thread, pre_state, labels, rel_rule.second, rel_rule.first, trace);
+                                }
+                            });
+                        }
+                        break;
+                    default:
+                        assert(false);
+                }
             }
         };
 
-        template <typename W, typename C, typename A, bool ET=false>
+        // The rules are read from a CompiledPDA, which is compiled from the PDA of the automaton unless one is given.
+        // Workset is the workset policy (see workset.h), which decides the order edges are processed in.
+        template <typename W, typename C, typename A, bool ET=false, Trace_Type trace_type = Trace_Type::Any, bool Stats=false,
+                  typename ETFn = early_termination_fn<W>, template<typename> class Workset = fifo_workset>
         class PostStarSaturation {
         public:
-            explicit PostStarSaturation(PAutomaton<W,C,A> &automaton, const early_termination_fn<W>& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; })
-                    : _automaton(automaton), _early_termination(early_termination), _pda_states(_automaton.pda().states()),
-                      _n_pda_states(_pda_states.size()), _n_Q(_automaton.states().size()) {
+            explicit PostStarSaturation(PAutomaton<W,C,A> &automaton, const ETFn& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; },
+                                        std::shared_ptr<const CompiledPDA<W,C>> compiled = nullptr, Workset<temp_edge_t> workset = Workset<temp_edge_t>())
+                    : _automaton(automaton), _early_termination(early_termination), _pda(compiled_pda(_automaton.pda(), std::move(compiled))),
+                      _n_pda_states(_pda->number_of_states()), _n_Q(_automaton.states().size()), _workset(std::move(workset)) {
                 initialize();
             };
 
@@ -226,36 +895,24 @@ namespace pdaaal {
             // http://www.lsv.fr/Publis/PAPERS/PDF/schwoon-phd02.pdf (page 48)
 
             PAutomaton<W,C,A>& _automaton;
-            const early_termination_fn<W>& _early_termination;
-            const std::vector<typename PDA<W,C>::state_t>& _pda_states;
+            const ETFn& _early_termination;
+            std::shared_ptr<const CompiledPDA<W,C>> _pda;
             const size_t _n_pda_states;
             const size_t _n_Q;
-            std::unordered_map<std::pair<size_t, uint32_t>, size_t, boost::hash<std::pair<size_t, uint32_t>>> _q_prime{};
 
+            Workset<temp_edge_t> _workset;
             size_t _n_automaton_states{};
-            std::unordered_set<temp_edge_t, temp_edge_hasher> _edges;
-            std::queue<temp_edge_t> _workset;
+            flat_edge_set _edges;
             std::vector<std::vector<std::pair<size_t,uint32_t>>> _rel1; // faster access for lookup _from -> (_to, _label)
             std::vector<std::vector<size_t>> _rel2; // faster access for lookup _to -> _from  (when _label is uint32_t::max)
 
             bool _found = false;
+            std::mutex* _automaton_lock = nullptr;
+            stats_recorder<Stats> _stats;
 
             void initialize() {
-                // for <p, y> -> <p', y1 y2> do  (line 3)
-                //   Q' U= {q_p'y1}              (line 4)
-                for (auto &state : _pda_states) {
-                    for (auto &[rule, labels] : state._rules) {
-                        if (rule._operation == PUSH) {
-                            auto res = _q_prime.emplace(std::make_pair(rule._to, rule._op_label), _automaton.next_state_id());
-                            if (res.second) {
-                                _automaton.add_state(false, false);
-                            }
-                        }
-                    }
-                }
-                _n_automaton_states = _automaton.states().size();
-                _rel1.resize(_n_automaton_states);
-                _rel2.resize(_n_automaton_states - _n_Q);
+                add_q_prime_states();
+                _edges.reserve(expected_edges(_automaton, *_pda));
 
                 // workset := ->_0 intersect (P x Gamma x Q)  (line 1)
                 // rel := ->_0 \ workset (line 2)
@@ -263,81 +920,89 @@ namespace pdaaal {
                     for (const auto &[to,labels] : from->_edges) {
                         assert(!labels.contains(epsilon)); // PostStar algorithm assumes no epsilon transitions in the NFA.
                         for (const auto &[label,_] : labels) {
-                            insert_edge(from->_id, label, to, nullptr, from->_id >= _n_pda_states);
+                            insert_edge(from->_id, label, to, no_trace, from->_id >= _n_pda_states);
                         }
                     }
                 }
             }
-            void insert_edge(size_t from, uint32_t label, size_t to, const trace_t *trace, bool direct_to_rel = false) {
-                auto res = _edges.emplace(from, label, to);
-                if (res.second) { // New edge is not already in edges (rel U workset).
+            // Held while adding an edge to the automaton and calling early termination, if another thread reads the automaton.
+            std::unique_lock<std::mutex> lock_automaton() {
+                return _automaton_lock == nullptr ? std::unique_lock<std::mutex>() : std::unique_lock<std::mutex>(*_automaton_lock);
+            }
+            trace_id new_post_trace(size_t from, size_t rule_id, uint32_t label) {
+                if constexpr (trace_type == Trace_Type::None) {
+                    return untraced;
+                } else {
+                    _stats.trace();
+                    return _automaton.new_post_trace(from, rule_id, label);
+                }
+            }
+            trace_id new_post_trace(size_t epsilon_state) {
+                if constexpr (trace_type == Trace_Type::None) {
+                    return untraced;
+                } else {
+                    _stats.trace();
+                    return _automaton.new_post_trace(epsilon_state);
+                }
+            }
+            void insert_edge(size_t from, uint32_t label, size_t to, trace_id trace, bool direct_to_rel = false) {
+                if (label != wildcard && label != epsilon && _edges.contains(from, wildcard, to)) { // Subsumed by the wildcard edge.
+                    _stats.duplicate_edge();
+                    return;
+                }
+                if (_edges.emplace(from, label, to)) { // New edge is not already in edges (rel U workset).
+                    _stats.edge_inserted();
                     if (direct_to_rel) {
                         _rel1[from].emplace_back(to, label);
                         if (label == epsilon && to >= _n_Q) {
                             _rel2[to - _n_Q].push_back(from);
                         }
                     } else {
-                        _workset.emplace(from, label, to);
+                        _workset.push(temp_edge_t{from, label, to});
+                        _stats.workset_size(_workset.size());
                     }
-                    if (trace != nullptr) { // Don't add existing edges
+                    auto guard = lock_automaton();
+                    if (trace != no_trace) { // Don't add existing edges
                         if (label == epsilon) {
-                            _automaton.add_epsilon_edge(from, to, trace_ptr_from<W>(trace));
+                            _automaton.add_epsilon_edge(from, to, stored_trace<trace_type,W>(trace));
                         } else {
-                            _automaton.add_edge(from, to, label, trace_ptr_from<W>(trace));
+                            _automaton.add_edge(from, to, label, stored_trace<trace_type,W>(trace));
                         }
                     }
                     if constexpr (ET) {
-                        _found = _found || _early_termination(from, label, to, trace_ptr_from<W>(trace));
+                        _found = _found || _early_termination(from, label, to, stored_trace<trace_type,W>(trace));
                     }
+                } else {
+                    _stats.duplicate_edge();
                 }
             };
 
         public:
             void step() {
                 // pop t = (q, y, q') from workset (line 6)
-                temp_edge_t t;
-                t = _workset.front();
-                _workset.pop();
+                auto t = _workset.pop();
+                _stats.step();
                 // rel = rel U {t} (line 8)   (membership test on line 7 is done in insert_edge).
                 _rel1[t._from].emplace_back(t._to, t._label);
                 if (t._label == epsilon && t._to >= _n_Q) {
                     _rel2[t._to - _n_Q].push_back(t._from);
                 }
 
-                // if y != epsilon (line 9)
-                if (t._label != epsilon) {
-                    const auto &rules = _pda_states[t._from]._rules;
-                    for (size_t rule_id = 0; rule_id < rules.size(); ++rule_id) {
-                        const auto &[rule,labels] = rules[rule_id];
-                        if (!labels.contains(t._label)) { continue; }
-                        auto trace = _automaton.new_post_trace(t._from, rule_id, t._label);
-                        switch (rule._operation) {
-                            case POP: // (line 10-11)
-                                insert_edge(rule._to, epsilon, t._to, trace, false);
-                                break;
-                            case SWAP: // (line 12-13)
-                                insert_edge(rule._to, rule._op_label, t._to, trace, false);
-                                break;
-                            case NOOP:
-                                insert_edge(rule._to, t._label, t._to, trace, false);
-                                break;
-                            case PUSH: // (line 14)
-                                assert(_q_prime.find(std::make_pair(rule._to, rule._op_label)) != std::end(_q_prime));
-                                size_t q_new = _q_prime[std::make_pair(rule._to, rule._op_label)];
-                                insert_edge(rule._to, rule._op_label, q_new, trace, false); // (line 15)
-                                insert_edge(q_new, t._label, t._to, trace, true); // (line 16)
-                                if (!_rel2[q_new - _n_Q].empty()) {
-                                    auto trace_q_new = _automaton.new_post_trace(q_new);
-                                    for (auto f : _rel2[q_new - _n_Q]) { // (line 17)
-                                        insert_edge(f, t._label, t._to, trace_q_new, false); // (line 18)
-                                    }
-                                }
-                                break;
-                        }
+                // if y != epsilon (line 9). A wildcard edge may match any rule, and for other labels the rule index gives the matching rules.
+                if (t._label == wildcard) {
+                    auto n_rules = _pda->rules(t._from).size();
+                    for (size_t rule_id = 0; rule_id < n_rules; ++rule_id) {
+                        apply_rule(t, rule_id);
                     }
+                } else if (t._label != epsilon) {
+                    _pda->label_index().for_each_rule(t._from, t._label, [this, &t](size_t rule_id) {
+                        _stats.rule_scanned();
+                        _stats.rule_matched();
+                        apply_rule(t, rule_id, t._label);
+                    });
                 } else {
                     if (!_rel1[t._to].empty()) {
-                        auto trace = _automaton.new_post_trace(t._to);
+                        auto trace = new_post_trace(t._to);
                         for (auto e : _rel1[t._to]) { // (line 20)
                             insert_edge(t._from, e.second, e.first, trace, false); // (line 21)
                         }
@@ -347,32 +1012,365 @@ namespace pdaaal {
             [[nodiscard]] bool workset_empty() const {
                 return _workset.empty();
             }
+            [[nodiscard]] size_t workset_size() const {
+                return _workset.size();
+            }
+            [[nodiscard]] size_t number_of_edges() const { // Edges found so far (rel U workset).
+                return _edges.size();
+            }
             [[nodiscard]] bool found() const {
                 return _found;
             }
+            [[nodiscard]] saturation_stats stats() const {
+                return _stats.get();
+            }
+            // Estimate of the memory used by the edges found so far (in the automaton and in the saturation) and the traces.
+            [[nodiscard]] size_t memory_bytes() const {
+                return _edges.memory_bytes() + _edges.size() * PAutomaton<W,C,A>::edge_bytes + _automaton.trace_memory_bytes();
+            }
+            // Use lock when adding edges to the automaton, so another thread can read the automaton (e.g. in early termination).
+            void set_automaton_lock(std::mutex* lock) {
+                _automaton_lock = lock;
+            }
+            // Saturate until the workset is empty or (if ET) early termination is reached.
+            void run() {
+                while (!_workset.empty()) {
+                    if constexpr (ET) {
+                        if (_found) return;
+                    }
+                    step();
+                }
+            }
+
+            // Incremental saturation: add_rules() may add rules between existing states to the PDA of the automaton.
+            // post* is monotone in the rules, so we keep the current edges, apply the new rules (and new labels of existing rules)
+            // to the processed edges, and continue to the new fixpoint. Rule ids in existing traces are updated to the new numbering.
+            template <typename Fn>
+            void add_rules(Fn&& add_rules) {
+                auto changes = update_pda_rules(_automaton.pda(), *_pda, std::forward<Fn>(add_rules));
+                if (!changes._removed.empty()) {
+                    throw std::logic_error("Incremental post* does not support removing rules.");
+                }
+                if (changes.empty()) return;
+                _pda = std::make_shared<const CompiledPDA<W,C>>(_automaton.pda(), *_pda);
+                _automaton.remap_rule_ids(changes._rule_map, false);
+                add_q_prime_states();
+                for (auto [state, rule_id] : changes._changed) {
+                    // apply_rule may append to _rel1[state], so iterate by index. Appended edges are also in the workset.
+                    for (size_t i = 0, n = _rel1[state].size(); i < n; ++i) {
+                        auto [to, label] = _rel1[state][i];
+                        if (label != epsilon) {
+                            apply_rule(temp_edge_t{state, label, to}, rule_id);
+                        }
+                    }
+                }
+                run();
+            }
+        private:
+            // for <p, y> -> <p', y1 y2> do  (line 3)
+            //   Q' U= {q_p'y1}              (line 4)
+            // Adds the states in Q' that are not yet in the automaton (all of them on the first call).
+            void add_q_prime_states() {
+                auto n_q_prime = _pda->q_prime().size();
+                assert(_automaton.states().size() <= _n_Q + n_q_prime);
+                while (_automaton.states().size() < _n_Q + n_q_prime) {
+                    _automaton.add_state(false, false);
+                    _stats.q_prime_state();
+                }
+                _n_automaton_states = _automaton.states().size();
+                _rel1.resize(_n_automaton_states);
+                _rel2.resize(_n_automaton_states - _n_Q);
+            }
+            // Apply rule number rule_id from t._from to the processed edge t, if the labels match.
+            void apply_rule(const temp_edge_t& t, size_t rule_id) {
+                auto labels = _pda->rules(t._from)[rule_id].second;
+                _stats.rule_scanned();
+                if (t._label == wildcard && !labels.wildcard()) {
+                    if (!labels.empty()) _stats.rule_matched();
+                    for (auto label : labels.labels()) { // A wildcard edge matches each label in the precondition.
+                        apply_rule(t, rule_id, label);
+                    }
+                } else if (labels_match(labels, t._label)) {
+                    _stats.rule_matched();
+                    apply_rule(t, rule_id, t._label);
+                }
+            }
+            // Line 10-18 for rule number rule_id from t._from applied to t with top of stack label (which is wildcard only if the precondition is).
+            void apply_rule(const temp_edge_t& t, size_t rule_id, uint32_t label) {
+                const auto &rule = _pda->rules(t._from)[rule_id].first;
+                auto trace = new_post_trace(t._from, rule_id, label);
+                switch (rule._operation) {
+                    case POP: // (line 10-11)
+                        insert_edge(rule._to, epsilon, t._to, trace, false);
+                        break;
+                    case SWAP: // (line 12-13)
+                        insert_edge(rule._to, rule._op_label, t._to, trace, false);
+                        break;
+                    case NOOP:
+                        insert_edge(rule._to, label, t._to, trace, false);
+                        break;
+                    case PUSH: // (line 14)
+                        size_t q_new = _n_Q + _pda->q_prime()(t._from, rule_id);
+                        insert_edge(rule._to, rule._op_label, q_new, trace, false); // (line 15)
+                        insert_edge(q_new, label, t._to, trace, true); // (line 16)
+                        if (!_rel2[q_new - _n_Q].empty()) {
+                            auto trace_q_new = new_post_trace(q_new);
+                            for (auto f : _rel2[q_new - _n_Q]) { // (line 17)
+                                insert_edge(f, label, t._to, trace_q_new, false); // (line 18)
+                            }
+                        }
+                        break;
+                }
+            }
         };
 
-        template<typename W, typename C, typename A, bool Enable, bool ET, typename = std::enable_if_t<Enable>>
+        // Multi-threaded version of PostStarSaturation. Each thread has its own workset and steals from the others when it runs empty.
+        // The Q' states are created up front (in the same order as PostStarSaturation), so the resulting automaton has the same states
+        // and accepts the same labels on each (from, to) pair as with PostStarSaturation, but the trace found for each edge may differ,
+        // and a concrete edge that is subsumed by a wildcard edge may or may not be present.
+        template <typename W, typename C, typename A, bool ET=false, Trace_Type trace_type = Trace_Type::Any, typename ETFn = early_termination_fn<W>>
+        class ParallelPostStarSaturation {
+        public:
+            ParallelPostStarSaturation(PAutomaton<W,C,A> &automaton, size_t n_threads, ETFn early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; },
+                                       std::shared_ptr<const CompiledPDA<W,C>> compiled = nullptr)
+                    : _automaton(automaton), _early_termination(std::move(early_termination)), _pda(compiled_pda(_automaton.pda(), std::move(compiled))),
+                      _n_pda_states(_pda->number_of_states()), _n_Q(_automaton.states().size()), _n_threads(std::max<size_t>(n_threads, 1)),
+                      _edges(_n_threads * 16), _workset(_n_threads), _rel_locks(_n_threads * 16),
+                      _automaton_locks(ET ? 1 : _n_threads * 16) {
+                initialize();
+            };
+
+            // Saturate until the worksets are empty or (if ET) early termination is reached.
+            void run() {
+                if constexpr (ET) {
+                    if (found()) return;
+                }
+                run_threads(_n_threads, [this](size_t thread){ work(thread); });
+            }
+            [[nodiscard]] bool found() const {
+                return _found.load(std::memory_order_relaxed);
+            }
+
+        private:
+            // This parallelizes Algorithm 2 (figure 3.4) in:
+            // Schwoon, Stefan. Model-checking pushdown systems. 2002. PhD Thesis. Technische Universität München.
+            // http://www.lsv.fr/Publis/PAPERS/PDF/schwoon-phd02.pdf (page 48)
+            // Line 16-18 and line 19-21 both pair an edge (q_new, y, q) in _rel1[q_new] with an epsilon edge (f, epsilon, q_new) in _rel2[q_new].
+            // Appending to one of these and reading the other is done in the same critical section (per q_new),
+            // so for each pair, the thread adding the last of the two sees the other.
+
+            PAutomaton<W,C,A>& _automaton;
+            ETFn _early_termination;
+            std::shared_ptr<const CompiledPDA<W,C>> _pda;
+            const size_t _n_pda_states;
+            const size_t _n_Q;
+            const size_t _n_threads;
+
+            size_t _n_automaton_states{};
+            concurrent_set<temp_edge_t, temp_edge_hasher> _edges;
+            work_stealing_workset<temp_edge_t> _workset;
+            striped_mutex _rel_locks; // Guards _rel1[q] and _rel2[q].
+            striped_mutex _automaton_locks; // Guards edges from a state in _automaton. With ET, a single lock also serializes _early_termination.
+            std::mutex _trace_lock;
+            std::vector<std::vector<std::pair<size_t,uint32_t>>> _rel1; // faster access for lookup _from -> (_to, _label)
+            std::vector<std::vector<size_t>> _rel2; // faster access for lookup _to -> _from  (when _label is uint32_t::max)
+            std::atomic<bool> _found = false;
+
+            void initialize() {
+                // for <p, y> -> <p', y1 y2> do  (line 3)
+                //   Q' U= {q_p'y1}              (line 4)
+                for (size_t i = 0; i < _pda->q_prime().size(); ++i) {
+                    _automaton.add_state(false, false);
+                }
+                _n_automaton_states = _automaton.states().size();
+                _rel1.resize(_n_automaton_states);
+                _rel2.resize(_n_automaton_states - _n_Q);
+
+                // workset := ->_0 intersect (P x Gamma x Q)  (line 1)
+                // rel := ->_0 \ workset (line 2)
+                size_t thread = 0;
+                for (const auto &from : _automaton.states()) {
+                    for (const auto &[to,labels] : from->_edges) {
+                        assert(!labels.contains(epsilon)); // PostStar algorithm assumes no epsilon transitions in the NFA.
+                        for (const auto &[label,_] : labels) {
+                            auto trace = no_new_trace();
+                            if (from->_id >= _n_pda_states) {
+                                if (insert_edge(thread, from->_id, label, to, trace, false)) {
+                                    _rel1[from->_id].emplace_back(to, label);
+                                }
+                            } else {
+                                insert_edge(thread, from->_id, label, to, trace);
+                                thread = (thread + 1) % _n_threads;
+                            }
+                        }
+                    }
+                }
+            }
+
+            trace_id new_post_trace(size_t from, size_t rule_id, uint32_t label) {
+                if constexpr (trace_type == Trace_Type::None) {
+                    return untraced;
+                } else {
+                    std::lock_guard<std::mutex> guard(_trace_lock);
+                    return _automaton.new_post_trace(from, rule_id, label);
+                }
+            }
+            trace_id new_post_trace(size_t epsilon_state) {
+                if constexpr (trace_type == Trace_Type::None) {
+                    return untraced;
+                } else {
+                    std::lock_guard<std::mutex> guard(_trace_lock);
+                    return _automaton.new_post_trace(epsilon_state);
+                }
+            }
+
+            // Returns true iff the edge was new. If to_workset is false, the caller is responsible for adding it to rel.
+            // The trace is only created (by make_trace) if the edge is new.
+            template <typename TraceFn>
+            bool insert_edge(size_t thread, size_t from, uint32_t label, size_t to, TraceFn& make_trace, bool to_workset = true) {
+                bool concrete = label != wildcard && label != epsilon;
+                if (concrete && _edges.contains(temp_edge_t{from, wildcard, to})) { // Subsumed by the wildcard edge.
+                    return false;
+                }
+                if (!_edges.insert(temp_edge_t{from, label, to})) { // Edge is already in edges (rel U workset).
+                    return false;
+                }
+                if (to_workset) {
+                    _workset.emplace(thread, from, label, to);
+                }
+                auto trace = make_trace();
+                if (trace != no_trace || ET) {
+                    std::lock_guard<std::mutex> guard(_automaton_locks[from]);
+                    // The wildcard edge may have been added since the check above. Then don't store a newer concrete edge.
+                    if (concrete && _automaton.has_wildcard_edge(from, to)) {
+                        return true;
+                    }
+                    if (trace != no_trace) { // Don't add existing edges
+                        if (label == epsilon) {
+                            _automaton.add_epsilon_edge(from, to, stored_trace<trace_type,W>(trace));
+                        } else {
+                            _automaton.add_edge(from, to, label, stored_trace<trace_type,W>(trace));
+                        }
+                    }
+                    if constexpr (ET) {
+                        if (!found() && _early_termination(from, label, to, stored_trace<trace_type,W>(trace))) {
+                            _found.store(true, std::memory_order_relaxed);
+                            _workset.stop(); // Wake up idle workers, so they see that we are done.
+                        }
+                    }
+                }
+                return true;
+            }
+
+            void work(size_t thread) {
+                temp_edge_t t;
+                while (true) {
+                    if constexpr (ET) {
+                        if (found()) return;
+                    }
+                    if (_workset.pop(thread, t)) {
+                        step(thread, t);
+                        _workset.done();
+                    } else if (_workset.finished()) {
+                        return;
+                    } else {
+                        _workset.wait();
+                    }
+                }
+            }
+
+            void step(size_t thread, const temp_edge_t& t) {
+                // if y != epsilon (line 9)
+                if (t._label != epsilon) {
+                    // rel = rel U {t} (line 8)   (membership test on line 7 is done in insert_edge).
+                    // t._from is a PDA state here, and only line 16-18 reads _rel1 of Q' states, so no pairing is needed.
+                    {
+                        std::lock_guard<std::mutex> guard(_rel_locks[t._from]);
+                        _rel1[t._from].emplace_back(t._to, t._label);
+                    }
+                    if (t._label == wildcard) {
+                        auto rules = _pda->rules(t._from);
+                        for (size_t rule_id = 0; rule_id < rules.size(); ++rule_id) {
+                            auto labels = rules[rule_id].second;
+                            if (!labels.wildcard()) {
+                                for (auto label : labels.labels()) { // A wildcard edge matches each label in the precondition.
+                                    apply_rule(thread, t, rule_id, label);
+                                }
+                            } else {
+                                apply_rule(thread, t, rule_id, t._label);
+                            }
+                        }
+                    } else {
+                        _pda->label_index().for_each_rule(t._from, t._label, [this, thread, &t](size_t rule_id) {
+                            apply_rule(thread, t, rule_id, t._label);
+                        });
+                    }
+                } else {
+                    // rel = rel U {t} (line 8)
+                    {
+                        std::lock_guard<std::mutex> guard(_rel_locks[t._from]);
+                        _rel1[t._from].emplace_back(t._to, t._label);
+                    }
+                    size_t n_rel1;
+                    {
+                        std::lock_guard<std::mutex> guard(_rel_locks[t._to]);
+                        if (t._to >= _n_Q) {
+                            _rel2[t._to - _n_Q].push_back(t._from);
+                        }
+                        n_rel1 = _rel1[t._to].size();
+                    }
+                    lazy_trace trace([this, &t]{ return new_post_trace(t._to); });
+                    for_each_prefix(_rel_locks[t._to], _rel1[t._to], n_rel1, [this, thread, &t, &trace](std::pair<size_t,uint32_t> e) { // (line 20)
+                        insert_edge(thread, t._from, e.second, e.first, trace); // (line 21)
+                    });
+                }
+            }
+
+            // Line 10-18 for rule number rule_id from t._from applied to t with top of stack label (which is wildcard only if the precondition is).
+            void apply_rule(size_t thread, const temp_edge_t& t, size_t rule_id, uint32_t label) {
+                const auto &rule = _pda->rules(t._from)[rule_id].first;
+                lazy_trace trace([this, &t, rule_id, label]{ return new_post_trace(t._from, rule_id, label); });
+                switch (rule._operation) {
+                    case POP: // (line 10-11)
+                        insert_edge(thread, rule._to, epsilon, t._to, trace);
+                        break;
+                    case SWAP: // (line 12-13)
+                        insert_edge(thread, rule._to, rule._op_label, t._to, trace);
+                        break;
+                    case NOOP:
+                        insert_edge(thread, rule._to, label, t._to, trace);
+                        break;
+                    case PUSH: { // (line 14)
+                        size_t q_new = _n_Q + _pda->q_prime()(t._from, rule_id);
+                        insert_edge(thread, rule._to, rule._op_label, q_new, trace); // (line 15)
+                        if (insert_edge(thread, q_new, label, t._to, trace, false)) { // (line 16)
+                            size_t n_rel2;
+                            {
+                                std::lock_guard<std::mutex> guard(_rel_locks[q_new]);
+                                _rel1[q_new].emplace_back(t._to, label);
+                                n_rel2 = _rel2[q_new - _n_Q].size();
+                            }
+                            lazy_trace trace_q_new([this, q_new]{ return new_post_trace(q_new); });
+                            for_each_prefix(_rel_locks[q_new], _rel2[q_new - _n_Q], n_rel2, [&](size_t f) { // (line 17)
+                                insert_edge(thread, f, label, t._to, trace_q_new); // (line 18)
+                            });
+                        }
+                        break;
+                    }
+                }
+            }
+        };
+
+        template<typename W, typename C, typename A, bool Enable, bool ET,
+                 template<typename,typename,typename,typename,typename> class Queue = binary_heap_queue, bool Stats = false,
+                 typename ETFn = early_termination_fn<W>, typename = std::enable_if_t<Enable>>
         class PostStarShortestSaturation {
             static_assert(is_weighted<W>);
 
-            struct weight_edge_trace {
-                W weight;
-                temp_edge_t edge;
-                const trace_t *trace = nullptr;
-                weight_edge_trace(W weight, temp_edge_t edge, const trace_t *trace) : weight(weight), edge(edge), trace(trace) {};
-                weight_edge_trace() = default;
-            };
-            struct weight_edge_trace_comp{
-                bool operator()(const weight_edge_trace &lhs, const weight_edge_trace &rhs){
-                    const C less;
-                    return less(rhs.weight, lhs.weight); // Used in a max-heap, so swap arguments to make it a min-heap.
-                }
-            };
             struct rel3_elem {
                 uint32_t _label;
                 size_t _to;
-                const trace_t *_trace;
+                trace_id _trace;
                 W _weight;
 
                 bool operator<(const rel3_elem &other) const {
@@ -388,45 +1386,39 @@ namespace pdaaal {
             };
 
         public:
-            PostStarShortestSaturation(PAutomaton<W,C,A> &automaton, const early_termination_fn<W>& early_termination)
-            : _automaton(automaton), _early_termination(early_termination), _pda_states(_automaton.pda().states()),
-              _n_pda_states(_pda_states.size()), _n_Q(_automaton.states().size()) {
+            PostStarShortestSaturation(PAutomaton<W,C,A> &automaton, const ETFn& early_termination, std::shared_ptr<const CompiledPDA<W,C>> compiled = nullptr)
+            : _automaton(automaton), _early_termination(early_termination), _pda(compiled_pda(_automaton.pda(), std::move(compiled))),
+              _n_pda_states(_pda->number_of_states()), _n_Q(_automaton.states().size()) {
                 initialize();
             };
 
         private:
             const A _add{};
-            const C _less{};
+            const weight_compare_t<W,C> _less{};
             PAutomaton<W,C,A>& _automaton;
-            const early_termination_fn<W>& _early_termination;
-            const std::vector<typename PDA<W,C>::state_t>& _pda_states;
+            const ETFn& _early_termination;
+            std::shared_ptr<const CompiledPDA<W,C>> _pda;
             const size_t _n_pda_states;
             const size_t _n_Q;
-            std::unordered_map<std::pair<size_t, uint32_t>, size_t, boost::hash<std::pair<size_t, uint32_t>>> _q_prime{};
 
             size_t _n_automaton_states{};
             std::vector<W> _minpath;
 
             std::unordered_map<temp_edge_t, std::pair<W,W>, temp_edge_hasher> _edge_weights;
-            std::priority_queue<weight_edge_trace, std::vector<weight_edge_trace>, weight_edge_trace_comp> _workset;
+            Queue<W,C,temp_edge_t,trace_id,temp_edge_hasher> _workset;
             std::vector<std::vector<std::pair<size_t,uint32_t>>> _rel1; // faster access for lookup _from -> (_to, _label)
             std::vector<std::vector<size_t>> _rel2; // faster access for lookup _to -> _from  (when _label is uint32_t::max)
             std::vector<std::vector<rel3_elem>> _rel3;
 
             bool _found = false;
+            stats_recorder<Stats> _stats;
 
             void initialize() {
                 // for <p, y> -> <p', y1 y2> do
                 //   Q' U= {q_p'y1}
-                for (const auto &state : _pda_states) {
-                    for (const auto &[rule,labels] : state._rules) {
-                        if (rule._operation == PUSH) {
-                            auto res = _q_prime.emplace(std::make_pair(rule._to, rule._op_label), _automaton.next_state_id());
-                            if (res.second) {
-                                _automaton.add_state(false, false);
-                            }
-                        }
-                    }
+                for (size_t i = 0; i < _pda->q_prime().size(); ++i) {
+                    _automaton.add_state(false, false);
+                    _stats.q_prime_state();
                 }
                 _n_automaton_states = _automaton.states().size();
                 _minpath.resize(_n_automaton_states - _n_Q);
@@ -440,19 +1432,30 @@ namespace pdaaal {
 
                 // workset := ->_0 intersect (P x Gamma x Q)
                 // rel := ->_0 \ workset
+                auto initial_edge = [this](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) {
+                    temp_edge_t temp_edge{from, label, to};
+                    _edge_weights.emplace(temp_edge, std::make_pair(zero<W>()(), zero<W>()()));
+                    if (from < _n_pda_states) {
+                        _workset.push(zero<W>()(), temp_edge, no_trace);
+                        _stats.workset_size(_workset.size());
+                    } else {
+                        insert_rel(from, label, to);
+                        if constexpr (ET) {
+                            _found = _found || _early_termination(from, label, to, trace);
+                        }
+                    }
+                };
                 for (auto &from : _automaton.states()) {
                     for (auto &[to,labels] : from->_edges) {
                         assert(!labels.contains(epsilon)); // PostStar algorithm assumes no epsilon transitions in the NFA.
                         for (auto &[label,trace] : labels) {
-                            temp_edge_t temp_edge{from->_id, label, to};
-                            _edge_weights.emplace(temp_edge, std::make_pair(zero<W>()(), zero<W>()()));
-                            if (from->_id < _n_pda_states) {
-                                _workset.emplace(zero<W>()(), temp_edge, nullptr);
-                            } else {
-                                insert_rel(from->_id, label, to);
-                                if constexpr (ET) {
-                                    _found = _found || _early_termination(from->_id, label, to, trace);
+                            if (label == wildcard) {
+                                // The weight of a trace depends on the concrete labels, so wildcard edges are expanded here.
+                                for (uint32_t l = 0; l < _automaton.number_of_labels(); ++l) {
+                                    initial_edge(from->_id, l, to, trace);
                                 }
+                            } else {
+                                initial_edge(from->_id, label, to, trace);
                             }
                         }
                     }
@@ -471,14 +1474,19 @@ namespace pdaaal {
                         (*res.first).second.second = workset_weight;
                         result.second = true;
                     }
+                    if (!result.first && !result.second) {
+                        _stats.duplicate_edge();
+                    }
                     return result;
                 }
+                _stats.edge_inserted();
                 return std::make_pair(res.second, res.second);
             }
-            void update_edge(size_t from, uint32_t label, size_t to, W edge_weight, const trace_t* trace) {
+            void update_edge(size_t from, uint32_t label, size_t to, W edge_weight, trace_id trace) {
                 auto workset_weight = to < _n_Q ? edge_weight : _add(_minpath[to - _n_Q], edge_weight);
                 if (update_edge_(from, label, to, edge_weight, workset_weight).second) {
-                    _workset.emplace(workset_weight, temp_edge_t{from, label, to}, trace);
+                    _workset.push(workset_weight, temp_edge_t{from, label, to}, trace);
+                    _stats.workset_size(_workset.size());
                 }
             }
             W get_weight(size_t from, uint32_t label, size_t to) const {
@@ -494,34 +1502,35 @@ namespace pdaaal {
         public:
             void step() {
                 // pop t = (q, y, q') from workset
-                auto elem = _workset.top();
-                _workset.pop();
-                auto t = elem.edge;
+                auto [elem_weight, t, elem_trace] = _workset.pop();
                 auto weights = (*_edge_weights.find(t)).second;
-                if (_less(weights.second, elem.weight)) {
+                if (_less(weights.second, elem_weight)) {
+                    _stats.stale_pop();
                     return; // Same edge with a smaller weight was already processed.
                 }
+                _stats.step();
                 auto t_weight = weights.first;
 
                 // rel = rel U {t}
                 insert_rel(t._from, t._label, t._to);
                 if (t._label == epsilon) {
-                    _automaton.add_epsilon_edge(t._from, t._to, std::make_pair(elem.trace, t_weight));
+                    _automaton.add_epsilon_edge(t._from, t._to, std::make_pair(elem_trace, t_weight));
                 } else {
-                    _automaton.add_edge(t._from, t._to, t._label, std::make_pair(elem.trace, t_weight));
+                    _automaton.add_edge(t._from, t._to, t._label, std::make_pair(elem_trace, t_weight));
                 }
                 if constexpr (ET) {
-                    _found = _found || _early_termination(t._from, t._label, t._to, std::make_pair(elem.trace, t_weight));
+                    _found = _found || _early_termination(t._from, t._label, t._to, std::make_pair(elem_trace, t_weight));
                 }
 
                 // if y != epsilon
                 if (t._label != epsilon) {
-                    const auto &rules = _pda_states[t._from]._rules;
-                    for (size_t rule_id = 0; rule_id < rules.size(); ++rule_id) {
-                        const auto &[rule,labels] = rules[rule_id];
-                        if (!labels.contains(t._label)) { continue; }
+                    _pda->label_index().for_each_rule(t._from, t._label, [this, &t = t, &elem_weight = elem_weight, &t_weight](size_t rule_id) {
+                        const auto &rule = _pda->rules(t._from)[rule_id].first;
+                        _stats.rule_scanned();
+                        _stats.rule_matched();
+                        _stats.trace();
                         auto trace = _automaton.new_post_trace(t._from, rule_id, t._label);
-                        auto wd = _add(elem.weight, rule._weight);
+                        auto wd = _add(elem_weight, rule._weight);
                         auto wb = _add(t_weight, rule._weight);
                         if (rule._operation != PUSH) {
                             uint32_t label = 0;
@@ -541,8 +1550,7 @@ namespace pdaaal {
                             }
                             update_edge(rule._to, label, t._to, wb, trace);
                         } else { // rule._operation == PUSH
-                            assert(_q_prime.find(std::make_pair(rule._to, rule._op_label)) != std::end(_q_prime));
-                            size_t q_new = _q_prime[std::make_pair(rule._to, rule._op_label)];
+                            size_t q_new = _n_Q + _pda->q_prime()(t._from, rule_id);
                             auto add_to_workset = update_edge_(rule._to, rule._op_label, q_new, zero<W>()(), wd).second;
                             auto was_updated = update_edge_(q_new, t._label, t._to, wb, zero<W>()()).first;
                             if (was_updated) {
@@ -558,10 +1566,12 @@ namespace pdaaal {
                             if (_less(wd, _minpath[q_new - _n_Q])) {
                                 _minpath[q_new - _n_Q] = wd;
                                 if (add_to_workset) {
-                                    _workset.emplace(wd, temp_edge_t{rule._to, rule._op_label, q_new}, trace);
+                                    _workset.push(wd, temp_edge_t{rule._to, rule._op_label, q_new}, trace);
+                                    _stats.workset_size(_workset.size());
                                 }
                             } else if (was_updated) {
                                 if (!_rel2[q_new - _n_Q].empty()) {
+                                    _stats.trace();
                                     auto trace_q_new = _automaton.new_post_trace(q_new);
                                     for (auto f : _rel2[q_new - _n_Q]) {
                                         update_edge(f, t._label, t._to, _add(get_weight(f, epsilon, q_new), wb), trace_q_new);
@@ -569,60 +1579,275 @@ namespace pdaaal {
                                 }
                             }
                         }
+                    });
+                } else {
+                    if (t._to < _n_Q) {
+                        if (!_rel1[t._to].empty()) {
+                            _stats.trace();
+                            auto trace = _automaton.new_post_trace(t._to);
+                            for (auto e : _rel1[t._to]) {
+                                assert(e.first >= _n_pda_states);
+                                update_edge(t._from, e.second, e.first, _add(get_weight(t._to, e.second, e.first), t_weight), trace);
+                            }
+                        }
+                    } else {
+                        if (!_rel3[t._to - _n_Q].empty()) {
+                            _stats.trace();
+                            auto trace = _automaton.new_post_trace(t._to);
+                            for (auto &e : _rel3[t._to - _n_Q]) {
+                                update_edge(t._from, e._label, e._to, _add(get_weight(t._to, e._label, e._to), t_weight), trace);
+                            }
+                        }
+                    }
+                }
+            }
+            void finalize() {
+                for (size_t i = _n_Q; i < _n_automaton_states; ++i) {
+                    for (auto &e : _rel3[i - _n_Q]) {
+                        assert(e._label != epsilon);
+                        _automaton.add_edge(i, e._to, e._label, std::make_pair(e._trace, e._weight));
+                        if constexpr (ET) {
+                            _found = _found || _early_termination(i, e._label, e._to, std::make_pair(e._trace, e._weight));
+                        }
+                    }
+                }
+            }
+            [[nodiscard]] bool workset_empty() const {
+                return _workset.empty();
+            }
+            [[nodiscard]] bool found() const {
+                return _found;
+            }
+            [[nodiscard]] saturation_stats stats() const {
+                return _stats.get();
+            }
+            // Estimate of the memory used by the edges found so far (in the automaton and in the saturation) and the traces.
+            [[nodiscard]] size_t memory_bytes() const {
+                constexpr size_t node_bytes = sizeof(typename decltype(_edge_weights)::value_type) + 2 * sizeof(void*);
+                return _edge_weights.size() * (node_bytes + PAutomaton<W,C,A>::edge_bytes) + _automaton.trace_memory_bytes();
+            }
+        };
+
+        // Weighted pre*, where the weight of an edge (p, y, q) is the weight of the shortest trace from a configuration <p, y w>,
+        // with w accepted from q, to a configuration accepted by the initial automaton. Edges in the initial automaton have weight zero.
+        // This is a generalization of Dijkstra's algorithm to the rules of pre* (Knuth, 1977): The weight of a new edge is the weight
+        // of a rule plus the weights of the one or two processed edges it is derived from, so edges are processed in order of their final weight.
+        // Wildcard labels in the initial automaton and in preconditions are expanded to all labels, so all new edges have a concrete label.
+        template <typename W, typename C, typename A, bool ET=false,
+                  template<typename,typename,typename,typename,typename> class Queue = binary_heap_queue, bool Stats = false,
+                  typename ETFn = early_termination_fn<W>>
+        class PreStarShortestSaturation {
+            static_assert(is_weighted<W>);
+        public:
+            explicit PreStarShortestSaturation(PAutomaton<W,C,A> &automaton, const ETFn& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; },
+                                               std::shared_ptr<const CompiledPDA<W,C>> compiled = nullptr)
+                    : _automaton(automaton), _early_termination(early_termination), _pda(compiled_pda(_automaton.pda(), std::move(compiled))),
+                      _n_pda_states(_pda->number_of_states()), _n_automaton_states(_automaton.states().size()), _n_labels(_automaton.number_of_labels()),
+                      _rel(_n_automaton_states), _delta_prime(_n_automaton_states) {
+                initialize();
+            };
+
+        private:
+            const A _add{};
+            const weight_compare_t<W,C> _less{};
+            PAutomaton<W,C,A>& _automaton;
+            const ETFn& _early_termination;
+            std::shared_ptr<const CompiledPDA<W,C>> _pda;
+            const size_t _n_pda_states;
+            const size_t _n_automaton_states;
+            const size_t _n_labels;
+            std::unordered_map<temp_edge_t, W, temp_edge_hasher> _edge_weights; // Smallest weight found so far for each edge in rel U workset.
+            Queue<W,C,temp_edge_t,trace_id,temp_edge_hasher> _workset;
+            std::vector<std::vector<std::tuple<size_t,uint32_t,W>>> _rel; // Processed edges: from -> (to, label, weight).
+            std::vector<std::vector<std::tuple<size_t,size_t,W>>> _delta_prime; // q -> (p, push rule, weight of rule and edge (p', y1, q)).
+            bool _found = false;
+            stats_recorder<Stats> _stats;
+
+            void initialize() {
+                // workset := ->_0
+                for (const auto &from : _automaton.states()) {
+                    for (const auto &[to,labels] : from->_edges) {
+                        for (const auto &[label,_] : labels) {
+                            if (label == wildcard) {
+                                for (uint32_t l = 0; l < _n_labels; ++l) {
+                                    update_edge(from->_id, l, to, zero<W>()(), []() { return no_trace; });
+                                }
+                            } else {
+                                update_edge(from->_id, label, to, zero<W>()(), []() { return no_trace; });
+                            }
+                        }
+                    }
+                }
+                // for all <p, y> --> <p', epsilon> : workset U= (p, y, p')
+                for (size_t to = 0; to < _n_pda_states; ++to) {
+                    for (const auto& ref : _pda->rules_into(to, POP)) {
+                        auto rule = _pda->rules(ref._from)[ref._rule_id];
+                        for_each_label(rule.second, [this, &ref, &rule, to](uint32_t label) {
+                            update_edge(ref._from, label, to, rule.first._weight, [this, &ref]() { return _automaton.new_pre_trace(ref._rule_id); });
+                        });
+                    }
+                }
+            }
+            template <typename Fn>
+            void for_each_label(const labels_view& labels, Fn&& fn) const {
+                if (labels.wildcard()) {
+                    for (uint32_t label = 0; label < _n_labels; ++label) {
+                        fn(label);
                     }
                 } else {
-                    if (t._to < _n_Q) {
-                        if (!_rel1[t._to].empty()) {
-                            auto trace = _automaton.new_post_trace(t._to);
-                            for (auto e : _rel1[t._to]) {
-                                assert(e.first >= _n_pda_states);
-                                update_edge(t._from, e.second, e.first, _add(get_weight(t._to, e.second, e.first), t_weight), trace);
-                            }
-                        }
-                    } else {
-                        if (!_rel3[t._to - _n_Q].empty()) {
-                            auto trace = _automaton.new_post_trace(t._to);
-                            for (auto &e : _rel3[t._to - _n_Q]) {
-                                update_edge(t._from, e._label, e._to, _add(get_weight(t._to, e._label, e._to), t_weight), trace);
-                            }
-                        }
+                    for (auto label : labels.labels()) {
+                        fn(label);
                     }
                 }
             }
-            void finalize() {
-                for (size_t i = _n_Q; i < _n_automaton_states; ++i) {
-                    for (auto &e : _rel3[i - _n_Q]) {
-                        assert(e._label != epsilon);
-                        _automaton.add_edge(i, e._to, e._label, std::make_pair(e._trace, e._weight));
-                        if constexpr (ET) {
-                            _found = _found || _early_termination(i, e._label, e._to, std::make_pair(e._trace, e._weight));
-                        }
+            // Add the edge to the workset if weight is smaller than its current weight. new_trace() is only called in that case.
+            template <typename TraceFn>
+            void update_edge(size_t from, uint32_t label, size_t to, const W& weight, TraceFn&& new_trace) {
+                auto [it, fresh] = _edge_weights.emplace(temp_edge_t{from, label, to}, weight);
+                if (fresh) {
+                    _stats.edge_inserted();
+                } else if (_less(weight, it->second)) {
+                    it->second = weight;
+                } else {
+                    _stats.duplicate_edge();
+                    return;
+                }
+                trace_id trace = new_trace();
+                if (trace != no_trace) _stats.trace();
+                _workset.push(weight, temp_edge_t{from, label, to}, trace);
+                _stats.workset_size(_workset.size());
+            }
+
+        public:
+            void step() {
+                // pop t = (q, y, q') with minimal weight from workset
+                auto [weight, t, trace] = _workset.pop();
+                if (_less(_edge_weights.find(t)->second, weight)) {
+                    _stats.stale_pop();
+                    return; // Same edge with a smaller weight was already processed.
+                }
+                _stats.step();
+                // rel = rel U {t}
+                _rel[t._from].emplace_back(t._to, t._label, weight);
+                if (trace != no_trace) { // Don't add existing edges
+                    _automaton.add_edge(t._from, t._to, t._label, std::make_pair(trace, weight));
+                    if constexpr (ET) {
+                        _found = _found || _early_termination(t._from, t._label, t._to, std::make_pair(trace, weight));
+                    }
+                }
+
+                // (\Delta')
+                for (const auto& [state, rule_id, push_weight] : _delta_prime[t._from]) {
+                    _stats.rule_scanned();
+                    if (_pda->rules(state)[rule_id].second.contains(t._label)) {
+                        _stats.rule_matched();
+                        update_edge(state, t._label, t._to, _add(push_weight, weight), [this, rule_id = rule_id, &t = t]() { return _automaton.new_pre_trace(rule_id, t._from); });
+                    }
+                }
+                // Rules going into q. Pop rules were applied in initialize.
+                if (t._from >= _n_pda_states) { return; }
+                for (auto operation : {SWAP, NOOP, PUSH}) {
+                    for (auto [pre_state, rule_id] : _pda->rules_into(t._from, operation)) {
+                        apply_rule(t, weight, pre_state, rule_id);
                     }
                 }
             }
             [[nodiscard]] bool workset_empty() const {
                 return _workset.empty();
             }
+            [[nodiscard]] size_t workset_size() const {
+                return _workset.size();
+            }
+            [[nodiscard]] size_t number_of_edges() const { // Edges found so far (rel U workset).
+                return _edge_weights.size();
+            }
             [[nodiscard]] bool found() const {
                 return _found;
             }
+            [[nodiscard]] saturation_stats stats() const {
+                return _stats.get();
+            }
+            // Estimate of the memory used by the edges found so far (in the automaton and in the saturation) and the traces.
+            [[nodiscard]] size_t memory_bytes() const {
+                constexpr size_t node_bytes = sizeof(typename decltype(_edge_weights)::value_type) + 2 * sizeof(void*);
+                return _edge_weights.size() * (node_bytes + PAutomaton<W,C,A>::edge_bytes) + _automaton.trace_memory_bytes();
+            }
+            // Saturate until the workset is empty or (if ET) early termination is reached.
+            void run() {
+                while (!_workset.empty()) {
+                    if constexpr (ET) {
+                        if (_found) return;
+                    }
+                    step();
+                }
+            }
+
+        private:
+            // Rule number rule_id from pre_state applied to the processed edge t with the given weight.
+            void apply_rule(const temp_edge_t& t, const W& weight, size_t pre_state, size_t rule_id) {
+                auto [rule, labels] = _pda->rules(pre_state)[rule_id];
+                _stats.rule_scanned();
+                auto rule_trace = [this, rule_id]() { return _automaton.new_pre_trace(rule_id); };
+                switch (rule._operation) {
+                    case SWAP:
+                        if (rule._op_label == t._label) {
+                            _stats.rule_matched();
+                            auto new_weight = _add(rule._weight, weight);
+                            for_each_label(labels, [&](uint32_t label) {
+                                update_edge(pre_state, label, t._to, new_weight, rule_trace);
+                            });
+                        }
+                        break;
+                    case NOOP:
+                        if (labels.contains(t._label)) {
+                            _stats.rule_matched();
+                            update_edge(pre_state, t._label, t._to, _add(rule._weight, weight), rule_trace);
+                        }
+                        break;
+                    case PUSH:
+                        if (rule._op_label == t._label) {
+                            _stats.rule_matched();
+                            auto push_weight = _add(rule._weight, weight);
+                            _delta_prime[t._to].emplace_back(pre_state, rule_id, push_weight);
+                            for (const auto& [to, label, rel_weight] : _rel[t._to]) {
+                                if (labels.contains(label)) {
+                                    update_edge(pre_state, label, to, _add(push_weight, rel_weight), [this, rule_id, &t]() { return _automaton.new_pre_trace(rule_id, t._to); });
+                                }
+                            }
+                        }
+                        break;
+                    case POP:
+                    default:
+                        break;
+                }
+            }
         };
 
+        // The pre* saturation for trace_type.
+        template <typename W, typename C, typename A, bool ET, Trace_Type trace_type, bool Stats, typename ETFn>
+        using pre_star_saturation_t = std::conditional_t<trace_type == Trace_Type::Shortest,
+                PreStarShortestSaturation<W,C,A,ET,binary_heap_queue,Stats,ETFn>, PreStarSaturation<W,C,A,ET,trace_type,Stats,ETFn>>;
+
         template <typename W, typename C, typename A>
         class TraceBack {
             using rule_t = user_rule_t<W,C>;
         public:
-            TraceBack(const PAutomaton<W,C,A>& automaton, std::deque<std::tuple<size_t, uint32_t, size_t>>&& edges)
-            : _automaton(automaton), _edges(std::move(edges)) { };
+            // state is the control state of the configuration given by edges, which is needed when the stack is empty.
+            TraceBack(const PAutomaton<W,C,A>& automaton, size_t state, std::deque<std::tuple<size_t, uint32_t, size_t>>&& edges)
+            : _automaton(automaton), _edges(std::move(edges)), _state(state) { };
         private:
             const PAutomaton<W,C,A>& _automaton;
             std::deque<std::tuple<size_t, uint32_t, size_t>> _edges;
+            size_t _state;
             bool _post = false;
         public:
             [[nodiscard]] bool post() const { return _post; }
             [[nodiscard]] const std::deque<std::tuple<size_t, uint32_t, size_t>>& edges() const { return _edges; }
+            // The control state of the current configuration. Unlike the first edge, this is also there when a pop rule emptied the stack.
+            [[nodiscard]] size_t state() const { return _state; }
             std::optional<rule_t> next() {
                 while(true) { // In case of post_epsilon_trace, keep going until a rule is found or we are done.
+                    if (_edges.empty()) return std::nullopt; // Done
                     auto[from, label, to] = _edges.back();
                     const trace_t* trace_label = _automaton.get_trace_label(from, label, to);
                     if (trace_label == nullptr) return std::nullopt; // Done
@@ -645,6 +1870,7 @@ namespace pdaaal {
                                 _edges.emplace_back(rule._to, rule._op_label, trace_label->_state);
                                 break;
                         }
+                        _state = rule._to;
                         return rule_t(from, label, rule);
                     } else if (trace_label->is_post_epsilon_trace()) {
                         // Intermediate post* trace
@@ -656,22 +1882,31 @@ namespace pdaaal {
                     } else { // post* trace
                         _post = true;
                         const auto &[rule, labels] = _automaton.pda().states()[trace_label->_state]._rules[trace_label->_rule_id];
+                        // A wildcard trace label means that the rule was applied to a wildcard edge. For NOOP and PUSH the label is
+                        // preserved, so we use the current (concrete) label. For POP and SWAP we choose a label in the precondition.
+                        uint32_t pre_label = trace_label->_label;
                         switch (rule._operation) {
                             case POP:
                             case SWAP:
+                                pre_label = pre_label == wildcard ? labels.first_label() : pre_label;
+                                _edges.emplace_back(trace_label->_state, pre_label, to);
+                                break;
                             case NOOP:
-                                _edges.emplace_back(trace_label->_state, trace_label->_label, to);
+                                pre_label = pre_label == wildcard ? label : pre_label;
+                                _edges.emplace_back(trace_label->_state, pre_label, to);
                                 break;
                             case PUSH:
                                 auto[from2, label2, to2] = _edges.back();
                                 _edges.pop_back();
                                 trace_label = _automaton.get_trace_label(from2, label2, to2);
                                 assert(trace_label != nullptr);
-                                _edges.emplace_back(trace_label->_state, trace_label->_label, to2);
+                                pre_label = trace_label->_label == wildcard ? label2 : trace_label->_label;
+                                _edges.emplace_back(trace_label->_state, pre_label, to2);
                                 break;
                         }
                         assert(from == rule._to);
-                        return rule_t(trace_label->_state, trace_label->_label, rule);
+                        _state = trace_label->_state;
+                        return rule_t(trace_label->_state, pre_label, rule);
                     }
                 }
             }
@@ -679,14 +1914,64 @@ namespace pdaaal {
 
     }
 
+    // Scheduling policies for Solver::dual_search, which decide whether the next step is done by pre* or post*.
+    // A policy is constructed at the start of the search, and next_is_pre_star is called before each step where both worksets are non-empty.
+    namespace dual_search_schedule {
+        // Alternate between one post* step and one pre* step.
+        struct alternate {
+            template <typename PreStar, typename PostStar>
+            bool next_is_pre_star(const PreStar&, const PostStar&) {
+                _pre_star = !_pre_star;
+                return _pre_star;
+            }
+        private:
+            bool _pre_star = true;
+        };
+        // Step the direction with the smaller workset, i.e. the smaller frontier.
+        struct workset_size {
+            template <typename PreStar, typename PostStar>
+            bool next_is_pre_star(const PreStar& pre_star, const PostStar& post_star) {
+                return pre_star.workset_size() <= post_star.workset_size();
+            }
+        };
+        // Step the direction that has found fewer edges, so both directions add edges at the same rate.
+        struct edge_count {
+            template <typename PreStar, typename PostStar>
+            bool next_is_pre_star(const PreStar& pre_star, const PostStar& post_star) {
+                return pre_star.number_of_edges() <= post_star.number_of_edges();
+            }
+        };
+        // Run each direction for a time slice of the given number of microseconds before switching.
+        template <size_t Microseconds = 1000>
+        struct time_slice {
+            template <typename PreStar, typename PostStar>
+            bool next_is_pre_star(const PreStar&, const PostStar&) {
+                if (++_steps == check_interval) { // Reading the clock is relatively expensive, so only do it every check_interval steps.
+                    _steps = 0;
+                    auto now = std::chrono::steady_clock::now();
+                    if (now - _slice_start >= std::chrono::microseconds(Microseconds)) {
+                        _pre_star = !_pre_star;
+                        _slice_start = now;
+                    }
+                }
+                return _pre_star;
+            }
+        private:
+            static constexpr size_t check_interval = 64;
+            bool _pre_star = false;
+            size_t _steps = 0;
+            std::chrono::steady_clock::time_point _slice_start = std::chrono::steady_clock::now();
+        };
+    }
+
     class Solver {
     public:
-        template <typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        template <typename Schedule = dual_search_schedule::alternate, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
         static bool dual_search_accepts(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance) {
             if (instance.template initialize_product<true>()) {
                 return true;
             }
-            return dual_search<W,C,A>(instance.final_automaton(), instance.initial_automaton(),
+            return dual_search<W,C,A,true,Schedule>(instance.final_automaton(), instance.initial_automaton(),
                 [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
                     return instance.add_final_edge(from, label, to, trace);
                 },
@@ -695,68 +1980,203 @@ namespace pdaaal {
                 }
             );
         }
-        template <typename W, typename C, typename A, bool ET=true>
+        // Interleaves pre* and post* steps as decided by Schedule (see dual_search_schedule).
+        // When one direction is saturated, the other continues alone until it is saturated or (if ET) early termination is reached.
+        template <typename W, typename C, typename A, bool ET=true, typename Schedule = dual_search_schedule::alternate, typename PreETFn, typename PostETFn>
         static bool dual_search(PAutomaton<W,C,A> &pre_star_automaton, PAutomaton<W,C,A> &post_star_automaton,
-                                const details::early_termination_fn<W>& pre_star_early_termination,
-                                const details::early_termination_fn<W>& post_star_early_termination) {
-            details::PreStarSaturation<W,C,A,ET> pre_star(pre_star_automaton, pre_star_early_termination);
-            details::PostStarSaturation<W,C,A,ET> post_star(post_star_automaton, post_star_early_termination);
-            if constexpr (ET) {
-                if (pre_star.found() || post_star.found()) return true;
+                                const PreETFn& pre_star_early_termination, const PostETFn& post_star_early_termination) {
+            details::no_governor no_limits;
+            return dual_search_impl<W,C,A,ET,Schedule>(pre_star_automaton, post_star_automaton,
+                                                       pre_star_early_termination, post_star_early_termination, no_limits) == solver_result::yes;
+        }
+        // Like dual_search, but returns solver_result::unknown if the governor stops the search.
+        // The memory budget covers both automata and saturations.
+        template <typename W, typename C, typename A, bool ET=true, typename Schedule = dual_search_schedule::alternate, typename PreETFn, typename PostETFn>
+        static solver_result dual_search(PAutomaton<W,C,A> &pre_star_automaton, PAutomaton<W,C,A> &post_star_automaton,
+                                         const PreETFn& pre_star_early_termination, const PostETFn& post_star_early_termination, governor& governor) {
+            return dual_search_impl<W,C,A,ET,Schedule>(pre_star_automaton, post_star_automaton,
+                                                       pre_star_early_termination, post_star_early_termination, governor);
+        }
+        template <typename Schedule = dual_search_schedule::alternate, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        static solver_result dual_search_accepts(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance, governor& governor) {
+            if (instance.template initialize_product<true>()) {
+                return solver_result::yes;
             }
-            while(!pre_star.workset_empty() && !post_star.workset_empty()) {
-                post_star.step();
-                if constexpr (ET) {
-                    if (post_star.found()) return true;
+            return dual_search<W,C,A,true,Schedule>(instance.final_automaton(), instance.initial_automaton(),
+                [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                    return instance.add_final_edge(from, label, to, trace);
+                },
+                [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                    return instance.add_initial_edge(from, label, to, trace);
+                }, governor);
+        }
+
+        // Like dual_search_accepts, but pre* and post* run on two threads. Adding edges to the product is serialized by one lock,
+        // and the first thread that finds an accepting state in the product stops both.
+        template <typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        static bool dual_search_accepts_parallel(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance) {
+            if (instance.template initialize_product<true>()) {
+                return true;
+            }
+            return dual_search_parallel<W,C,A>(instance.final_automaton(), instance.initial_automaton(),
+                [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                    return instance.add_final_edge(from, label, to, trace);
+                },
+                [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                    return instance.add_initial_edge(from, label, to, trace);
                 }
-                pre_star.step();
-                if constexpr (ET) {
-                    if (pre_star.found()) return true;
+            );
+        }
+        // Two-threaded dual search. The early termination functions are called while holding a lock that also guards adding edges
+        // to both automata, so they may read both automata. When one direction is saturated, the other continues alone.
+        template <typename W, typename C, typename A, typename PreETFn, typename PostETFn>
+        static bool dual_search_parallel(PAutomaton<W,C,A> &pre_star_automaton, PAutomaton<W,C,A> &post_star_automaton,
+                                         const PreETFn& pre_star_early_termination, const PostETFn& post_star_early_termination) {
+            details::PreStarSaturation<W,C,A,true,Trace_Type::Any,false,PreETFn> pre_star(pre_star_automaton, pre_star_early_termination);
+            details::PostStarSaturation<W,C,A,true,Trace_Type::Any,false,PostETFn> post_star(post_star_automaton, post_star_early_termination);
+            if (pre_star.found() || post_star.found()) return true;
+            std::mutex automaton_lock;
+            pre_star.set_automaton_lock(&automaton_lock);
+            post_star.set_automaton_lock(&automaton_lock);
+            std::atomic<bool> stop = false;
+            auto saturate = [&stop](auto& saturation) {
+                while (!saturation.workset_empty() && !stop.load(std::memory_order_relaxed)) {
+                    saturation.step();
+                    if (saturation.found()) {
+                        stop.store(true, std::memory_order_relaxed);
+                    }
                 }
-            }
+            };
+            details::run_threads(2, [&](size_t thread) {
+                if (thread == 0) {
+                    saturate(pre_star);
+                } else {
+                    saturate(post_star);
+                }
+            });
             return pre_star.found() || post_star.found();
         }
 
-        template <typename W, typename C, typename A>
+        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A>
         static bool pre_star_accepts(PAutomaton<W,C,A> &automaton, size_t state, const std::vector<uint32_t> &stack) {
             if (stack.size() == 1) {
                 auto s_label = stack[0];
-                return pre_star<W,C,A,true>(automaton, [&automaton, state, s_label](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
-                    return from == state && label == s_label && automaton.states()[to]->_accepting;
+                return pre_star<trace_type,W,C,A,true>(automaton, [&automaton, state, s_label](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                    return from == state && (label == s_label || label == details::wildcard) && automaton.states()[to]->_accepting;
                 });
             } else {
-                return pre_star<W,C,A>(automaton) || automaton.accepts(state, stack);
+                return pre_star<trace_type,W,C,A,false>(automaton) || automaton.accepts(state, stack);
             }
         }
 
-        template <typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
         static bool pre_star_accepts(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance) {
             instance.enable_pre_star();
             return instance.initialize_product() ||
-                   pre_star<W,C,A,true>(instance.automaton(), [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                   pre_star<trace_type,W,C,A,true>(instance.automaton(), [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
                        return instance.add_edge_product(from, label, to, trace);
                    });
         }
+        // Same as pre_star_accepts(instance), and sets stats to the work done by the saturation.
+        template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        static bool pre_star_accepts(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance, saturation_stats& stats) {
+            static_assert(is_weighted<W> || trace_type != Trace_Type::Shortest, "Cannot do shortest-trace pre* for PDA without weights.");
+            stats = saturation_stats{};
+            instance.enable_pre_star();
+            return instance.initialize_product() ||
+                   pre_star_impl<W,C,A,true,trace_type,true>(instance.automaton(), [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                       return instance.add_edge_product(from, label, to, trace);
+                   }, &stats);
+        }
 
-        template <typename W, typename C, typename A, bool ET=false>
-        static bool pre_star(PAutomaton<W,C,A> &automaton,
-                             const details::early_termination_fn<W>& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; }) {
-            details::PreStarSaturation<W,C,A,ET> saturation(automaton, early_termination);
-            while(!saturation.workset_empty()) {
-                if constexpr (ET) {
-                    if (saturation.found()) return true;
-                }
-                saturation.step();
+        // Like pre_star_accepts(instance), but returns solver_result::unknown if the governor stops the saturation.
+        // The memory budget covers the pre* automaton and saturation, but not the product automaton.
+        template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        static solver_result pre_star_accepts(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance, governor& governor) {
+            instance.enable_pre_star();
+            if (instance.initialize_product()) {
+                return solver_result::yes;
             }
+            return pre_star<trace_type,W,C,A,true>(instance.automaton(), [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                return instance.add_edge_product(from, label, to, trace);
+            }, governor);
+        }
+
+        // Like pre_star_accepts(instance), but reads the rules from compiled (see pre_star with a CompiledPDA).
+        template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        static bool pre_star_accepts(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance, std::shared_ptr<const CompiledPDA<W,C>> compiled) {
+            instance.enable_pre_star();
+            return instance.initialize_product() ||
+                   pre_star<trace_type,W,C,A,true>(instance.automaton(), std::move(compiled), [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                       return instance.add_edge_product(from, label, to, trace);
+                   });
+        }
+
+        // Saturate the automaton and return the saturation object. Keep it alive to later add rules to the PDA and continue
+        // the saturation from where it stopped, instead of starting over: saturation.add_rules([&](){ pda.add_rule(...); });
+        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A>
+        static details::PreStarSaturation<W,C,A,false,trace_type> pre_star_incremental(PAutomaton<W,C,A> &automaton) {
+            static_assert(trace_type != Trace_Type::Shortest, "Incremental shortest-trace pre* is not supported.");
+            details::PreStarSaturation<W,C,A,false,trace_type> saturation(automaton);
+            saturation.run();
+            return saturation;
+        }
+
+        // With Trace_Type::None no traces are recorded, so the saturated automaton can only be used for yes/no answers.
+        // With Trace_Type::Shortest (weighted PDA only), each new edge gets the weight of its shortest trace (see PreStarShortestSaturation).
+        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A, bool ET=false, typename ETFn = details::early_termination_fn<W>,
+                  typename = std::enable_if_t<details::is_early_termination_fn<ETFn,W>>>
+        static bool pre_star(PAutomaton<W,C,A> &automaton, const ETFn& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; }) {
+            static_assert(is_weighted<W> || trace_type != Trace_Type::Shortest, "Cannot do shortest-trace pre* for PDA without weights.");
+            return pre_star_impl<W,C,A,ET,trace_type,false>(automaton, early_termination, nullptr);
+        }
+        // Like pre_star, but stops with solver_result::unknown when the governor hits a limit. Otherwise returns yes iff early termination was reached.
+        // As in dual_search, the governor is the last argument.
+        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A, bool ET=false, typename ETFn>
+        static solver_result pre_star(PAutomaton<W,C,A> &automaton, const ETFn& early_termination, governor& governor) {
+            static_assert(is_weighted<W> || trace_type != Trace_Type::Shortest, "Cannot do shortest-trace pre* for PDA without weights.");
+            details::pre_star_saturation_t<W,C,A,ET,trace_type,false,ETFn> saturation(automaton, early_termination);
+            return run_governed(saturation, governor);
+        }
+        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A>
+        static solver_result pre_star(PAutomaton<W,C,A> &automaton, governor& governor) {
+            return pre_star<trace_type,W,C,A,false>(automaton, details::early_termination_fn<W>([](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; }), governor);
+        }
+        // Like pre_star, but reads the rules from compiled, which must be compiled from the PDA of the automaton (or an identical PDA).
+        // Compile a PDA once and share it between solves, e.g. for many queries on the same PDA. Throws std::logic_error if compiled does not match.
+        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A, bool ET=false, typename ETFn = details::early_termination_fn<W>>
+        static bool pre_star(PAutomaton<W,C,A> &automaton, std::shared_ptr<const CompiledPDA<W,C>> compiled,
+                             const ETFn& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; }) {
+            static_assert(is_weighted<W> || trace_type != Trace_Type::Shortest, "Cannot do shortest-trace pre* for PDA without weights.");
+            return pre_star_impl<W,C,A,ET,trace_type,false>(automaton, early_termination, nullptr, std::move(compiled));
+        }
+
+        // Multi-threaded pre*. Gives the same answer and saturated automaton (up to choice of traces) as pre_star.
+        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A, bool ET=false, typename ETFn = details::early_termination_fn<W>,
+                  typename = std::enable_if_t<details::is_early_termination_fn<ETFn,W>>>
+        static bool pre_star_parallel(PAutomaton<W,C,A> &automaton, size_t n_threads = details::default_thread_count(),
+                                      const ETFn& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; }) {
+            static_assert(trace_type != Trace_Type::Shortest, "Shortest-trace pre* is not supported in parallel. Use pre_star.");
+            details::ParallelPreStarSaturation<W,C,A,ET,trace_type,ETFn> saturation(automaton, n_threads, early_termination);
+            saturation.run();
             return saturation.found();
         }
 
+        template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        static bool pre_star_accepts_parallel(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance, size_t n_threads = details::default_thread_count()) {
+            instance.enable_pre_star();
+            return instance.initialize_product() ||
+                   pre_star_parallel<trace_type,W,C,A,true>(instance.automaton(), n_threads, [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                       return instance.add_edge_product(from, label, to, trace);
+                   });
+        }
+
         template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A>
         static bool post_star_accepts(PAutomaton<W,C,A> &automaton, size_t state, const std::vector<uint32_t> &stack) {
             if (stack.size() == 1) {
                 auto s_label = stack[0];
                 return post_star<trace_type,W,C,A,true>(automaton, [&automaton, state, s_label](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
-                    return from == state && label == s_label && automaton.states()[to]->_accepting;
+                    return from == state && (label == s_label || label == details::wildcard) && automaton.states()[to]->_accepting;
                 });
             } else {
                 return post_star<trace_type,W,C,A>(automaton) || automaton.accepts(state, stack);
@@ -770,30 +2190,187 @@ namespace pdaaal {
                        return instance.add_edge_product(from, label, to, trace);
                    });
         }
+        // Like post_star_accepts(instance), but returns solver_result::unknown if the governor stops the saturation.
+        // The memory budget covers the post* automaton and saturation, but not the product automaton.
+        template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        static solver_result post_star_accepts(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance, governor& governor) {
+            if (instance.initialize_product()) {
+                return solver_result::yes;
+            }
+            return post_star<trace_type,W,C,A,true>(instance.automaton(), [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                return instance.add_edge_product(from, label, to, trace);
+            }, governor);
+        }
+        // Like post_star_accepts(instance), but reads the rules from compiled (see post_star with a CompiledPDA).
+        template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        static bool post_star_accepts(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance, std::shared_ptr<const CompiledPDA<W,C>> compiled) {
+            return instance.initialize_product() ||
+                   post_star<trace_type,W,C,A,true>(instance.automaton(), std::move(compiled), [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                       return instance.add_edge_product(from, label, to, trace);
+                   });
+        }
+        // Same as post_star_accepts(instance), and sets stats to the work done by the saturation.
+        template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        static bool post_star_accepts(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance, saturation_stats& stats) {
+            static_assert(is_weighted<W> || trace_type != Trace_Type::Shortest, "Cannot do shortest-trace post* for PDA without weights.");
+            stats = saturation_stats{};
+            if (instance.initialize_product()) return true;
+            auto early_termination = [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                return instance.add_edge_product(from, label, to, trace);
+            };
+            if constexpr (is_weighted<W> && trace_type == Trace_Type::Shortest) {
+                return post_star_shortest<W,C,A,true,true,binary_heap_queue,true>(instance.automaton(), early_termination, &stats);
+            } else {
+                return post_star_any<W,C,A,true,trace_type,true>(instance.automaton(), early_termination, &stats);
+            }
+        }
+
+        // Like pre_star_accepts(instance) and post_star_accepts(instance), but in the fused mode of the instance (see initialize_fused),
+        // which tags the saturated states with states of the final automaton instead of storing a product automaton.
+        // get_trace works as usual afterwards, but only for Trace_Type::Any.
+        template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        static bool pre_star_accepts_fused(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance) {
+            instance.enable_pre_star();
+            return instance.initialize_fused() ||
+                   pre_star<trace_type,W,C,A,true>(instance.automaton(), [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                       return instance.add_edge_fused(from, label, to, trace);
+                   });
+        }
+        template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        static bool post_star_accepts_fused(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance) {
+            return instance.initialize_fused() ||
+                   post_star<trace_type,W,C,A,true>(instance.automaton(), [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                       return instance.add_edge_fused(from, label, to, trace);
+                   });
+        }
 
-        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A, bool ET = false>
-        static bool post_star(PAutomaton<W,C,A> &automaton,
-                              const details::early_termination_fn<W>& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; }) {
+        // Queue is the priority queue policy (see priority_queue.h) used by shortest-trace post*. It is ignored for other trace types.
+        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A, bool ET = false,
+                  template<typename,typename,typename,typename,typename> class Queue = binary_heap_queue, typename ETFn = details::early_termination_fn<W>,
+                  typename = std::enable_if_t<details::is_early_termination_fn<ETFn,W>>>
+        static bool post_star(PAutomaton<W,C,A> &automaton, const ETFn& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; }) {
             static_assert(is_weighted<W> || trace_type != Trace_Type::Shortest, "Cannot do shortest-trace post* for PDA without weights."); // TODO: Consider: W=uin32_t, weight==1 as a default weight.
             if constexpr (is_weighted<W> && trace_type == Trace_Type::Shortest) {
-                return post_star_shortest<W,C,A,true,ET>(automaton, early_termination);
-            } else if constexpr (trace_type == Trace_Type::Any) {
-                return post_star_any<W,C,A,ET>(automaton, early_termination);
-            } else if constexpr (trace_type == Trace_Type::None) {
-                return post_star_any<W,C,A,ET>(automaton, early_termination); // TODO: Implement faster no-trace option.
+                return post_star_shortest<W,C,A,true,ET,Queue>(automaton, early_termination);
+            } else {
+                return post_star_any<W,C,A,ET,trace_type>(automaton, early_termination);
             }
         }
 
-        template <typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        // Like post_star, but stops with solver_result::unknown when the governor hits a limit. Otherwise returns yes iff early termination was reached.
+        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A, bool ET = false,
+                  template<typename,typename,typename,typename,typename> class Queue = binary_heap_queue, typename ETFn>
+        static solver_result post_star(PAutomaton<W,C,A> &automaton, const ETFn& early_termination, governor& governor) {
+            static_assert(is_weighted<W> || trace_type != Trace_Type::Shortest, "Cannot do shortest-trace post* for PDA without weights.");
+            if constexpr (is_weighted<W> && trace_type == Trace_Type::Shortest) {
+                details::PostStarShortestSaturation<W,C,A,true,ET,Queue,false,ETFn> saturation(automaton, early_termination);
+                auto result = run_governed(saturation, governor);
+                if (result != solver_result::unknown) {
+                    saturation.finalize();
+                    return saturation.found() ? solver_result::yes : solver_result::no;
+                }
+                return result;
+            } else {
+                details::PostStarSaturation<W,C,A,ET,trace_type,false,ETFn> saturation(automaton, early_termination);
+                return run_governed(saturation, governor);
+            }
+        }
+        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A>
+        static solver_result post_star(PAutomaton<W,C,A> &automaton, governor& governor) {
+            return post_star<trace_type,W,C,A,false>(automaton, details::early_termination_fn<W>([](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; }), governor);
+        }
+
+        // Like post_star, but reads the rules from compiled, which must be compiled from the PDA of the automaton (or an identical PDA).
+        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A, bool ET = false,
+                  template<typename,typename,typename,typename,typename> class Queue = binary_heap_queue, typename ETFn = details::early_termination_fn<W>>
+        static bool post_star(PAutomaton<W,C,A> &automaton, std::shared_ptr<const CompiledPDA<W,C>> compiled,
+                              const ETFn& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; }) {
+            static_assert(is_weighted<W> || trace_type != Trace_Type::Shortest, "Cannot do shortest-trace post* for PDA without weights.");
+            if constexpr (is_weighted<W> && trace_type == Trace_Type::Shortest) {
+                return post_star_shortest<W,C,A,true,ET,Queue>(automaton, early_termination, nullptr, std::move(compiled));
+            } else {
+                return post_star_any<W,C,A,ET,trace_type>(automaton, early_termination, nullptr, std::move(compiled));
+            }
+        }
+
+        // Like pre_star and post_star, but processes the edges in the order given by the workset policy Workset (see workset.h),
+        // e.g. pre_star_with_workset<fifo_workset>(automaton). Shortest-trace saturation is not supported, since it has its own order.
+        template <template<typename> class Workset, Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A, bool ET = false,
+                  typename ETFn = details::early_termination_fn<W>>
+        static bool pre_star_with_workset(PAutomaton<W,C,A> &automaton, Workset<details::temp_edge_t> workset = Workset<details::temp_edge_t>(),
+                                          const ETFn& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; }) {
+            static_assert(trace_type != Trace_Type::Shortest, "Shortest-trace pre* with a workset policy is not supported. Use pre_star.");
+            details::PreStarSaturation<W,C,A,ET,trace_type,false,ETFn,Workset> saturation(automaton, early_termination, nullptr, std::move(workset));
+            saturation.run();
+            return saturation.found();
+        }
+        template <template<typename> class Workset, Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A, bool ET = false,
+                  typename ETFn = details::early_termination_fn<W>>
+        static bool post_star_with_workset(PAutomaton<W,C,A> &automaton, Workset<details::temp_edge_t> workset = Workset<details::temp_edge_t>(),
+                                           const ETFn& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; }) {
+            static_assert(trace_type != Trace_Type::Shortest, "Shortest-trace post* with a workset policy is not supported. Use post_star.");
+            details::PostStarSaturation<W,C,A,ET,trace_type,false,ETFn,Workset> saturation(automaton, early_termination, nullptr, std::move(workset));
+            saturation.run();
+            return saturation.found();
+        }
+
+        // Like post_star_accepts(instance), but processes first the edges whose control state is fewest rules away from
+        // a state where the final automaton accepts something (see goal_distance), so a witness is often found with fewer edges.
+        template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        static bool post_star_accepts_goal_directed(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance) {
+            if (instance.initialize_product()) return true;
+            const auto& final_states = instance.final_automaton().states();
+            std::vector<size_t> goal_states;
+            for (size_t p = 0; p < instance.pda().states().size(); ++p) {
+                if (final_states[p]->_accepting || !final_states[p]->_edges.empty()) {
+                    goal_states.push_back(p);
+                }
+            }
+            return post_star_with_workset<heuristic_order<goal_distance>::template workset,trace_type,W,C,A,true>(instance.automaton(),
+                    heuristic_workset<details::temp_edge_t,goal_distance>(goal_distance(instance.pda(), goal_states)),
+                    [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                        return instance.add_edge_product(from, label, to, trace);
+                    });
+        }
+
+        // Saturate the automaton and return the saturation object, which can continue after rules are added (see pre_star_incremental).
+        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A>
+        static details::PostStarSaturation<W,C,A,false,trace_type> post_star_incremental(PAutomaton<W,C,A> &automaton) {
+            static_assert(trace_type != Trace_Type::Shortest, "Incremental shortest-trace post* is not supported.");
+            details::PostStarSaturation<W,C,A,false,trace_type> saturation(automaton);
+            saturation.run();
+            return saturation;
+        }
+
+        // Multi-threaded post*. Gives the same answer and saturated automaton (up to choice of traces) as post_star.
+        template <Trace_Type trace_type = Trace_Type::Any, typename W, typename C, typename A, bool ET = false, typename ETFn = details::early_termination_fn<W>,
+                  typename = std::enable_if_t<details::is_early_termination_fn<ETFn,W>>>
+        static bool post_star_parallel(PAutomaton<W,C,A> &automaton, size_t n_threads = details::default_thread_count(),
+                                       const ETFn& early_termination = [](size_t f, uint32_t l, size_t t, trace_ptr<W> trace) -> bool { return false; }) {
+            static_assert(trace_type != Trace_Type::Shortest, "Shortest-trace post* is not supported in parallel. Use post_star.");
+            details::ParallelPostStarSaturation<W,C,A,ET,trace_type,ETFn> saturation(automaton, n_threads, early_termination);
+            saturation.run();
+            return saturation.found();
+        }
+
+        template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
+        static bool post_star_accepts_parallel(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance, size_t n_threads = details::default_thread_count()) {
+            return instance.initialize_product() ||
+                   post_star_parallel<trace_type,W,C,A,true>(instance.automaton(), n_threads, [&instance](size_t from, uint32_t label, size_t to, trace_ptr<W> trace) -> bool {
+                       return instance.add_edge_product(from, label, to, trace);
+                   });
+        }
+
+        template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
         static bool pre_star_accepts_no_ET(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance) {
             instance.enable_pre_star();
-            pre_star<W,C,A,false>(instance.automaton());
-            return instance.initialize_product();
+            pre_star<trace_type,W,C,A,false>(instance.automaton());
+            return instance.template initialize_product<false, trace_type == Trace_Type::Shortest>();
         }
         template <Trace_Type trace_type = Trace_Type::Any, typename pda_t, typename automaton_t, typename T, typename W, typename C, typename A>
         static bool post_star_accepts_no_ET(SolverInstance_impl<pda_t,automaton_t,T,W,C,A>& instance) {
             post_star<trace_type,W,C,A,false>(instance.automaton());
-            return instance.initialize_product();
+            return instance.template initialize_product<false, trace_type == Trace_Type::Shortest>();
         }
 
         template <Trace_Type trace_type = Trace_Type::Any, typename T, typename W, typename C, typename A>
@@ -861,22 +2438,104 @@ namespace pdaaal {
             }
         }
 
+        // Enumerate the traces from <state, stack> to the initial configurations of an automaton saturated by pre_star<Trace_Type::Shortest>, cheapest first.
+        template <typename T, typename W, typename C, typename A>
+        static KShortestTraces<T,W,C,A> pre_star_shortest_traces(const TypedPDA<T,W,C>& pda, const PAutomaton<W,C,A>& automaton, size_t state, const std::vector<T>& stack) {
+            return KShortestTraces<T,W,C,A>(pda, automaton, false, state, pda.encode_pre(stack));
+        }
+        template <typename T, typename W, typename C, typename A, typename = std::enable_if_t<!std::is_same_v<T,uint32_t>>>
+        static KShortestTraces<T,W,C,A> pre_star_shortest_traces(const TypedPDA<T,W,C>& pda, const PAutomaton<W,C,A>& automaton, size_t state, const std::vector<uint32_t>& stack_native) {
+            return KShortestTraces<T,W,C,A>(pda, automaton, false, state, stack_native);
+        }
+        // Enumerate the traces from the initial configurations of an automaton saturated by post_star<Trace_Type::Shortest> to <state, stack>, cheapest first.
+        template <typename T, typename W, typename C, typename A>
+        static KShortestTraces<T,W,C,A> post_star_shortest_traces(const TypedPDA<T,W,C>& pda, const PAutomaton<W,C,A>& automaton, size_t state, const std::vector<T>& stack) {
+            return KShortestTraces<T,W,C,A>(pda, automaton, true, state, pda.encode_pre(stack));
+        }
+        template <typename T, typename W, typename C, typename A, typename = std::enable_if_t<!std::is_same_v<T,uint32_t>>>
+        static KShortestTraces<T,W,C,A> post_star_shortest_traces(const TypedPDA<T,W,C>& pda, const PAutomaton<W,C,A>& automaton, size_t state, const std::vector<uint32_t>& stack_native) {
+            return KShortestTraces<T,W,C,A>(pda, automaton, true, state, stack_native);
+        }
+
     private:
-        template <typename W, typename C, typename A, bool ET>
-        static bool post_star_any(PAutomaton<W,C,A> &automaton, const details::early_termination_fn<W>& early_termination) {
-            details::PostStarSaturation<W,C,A,ET> saturation(automaton, early_termination);
-            while(!saturation.workset_empty()) {
+        // Run the saturation until it is saturated, early termination is reached, or the governor stops it.
+        template <typename Saturation, typename Governor>
+        static solver_result run_governed(Saturation& saturation, Governor& governor) {
+            while (!saturation.workset_empty()) {
+                if (saturation.found()) return solver_result::yes;
+                if (governor.should_stop([&saturation]() { return saturation.memory_bytes(); })) return solver_result::unknown;
+                saturation.step();
+            }
+            return saturation.found() ? solver_result::yes : solver_result::no;
+        }
+
+        template <typename W, typename C, typename A, bool ET, typename Schedule, typename PreETFn, typename PostETFn, typename Governor>
+        static solver_result dual_search_impl(PAutomaton<W,C,A> &pre_star_automaton, PAutomaton<W,C,A> &post_star_automaton,
+                                              const PreETFn& pre_star_early_termination, const PostETFn& post_star_early_termination, Governor& governor) {
+            details::PreStarSaturation<W,C,A,ET,Trace_Type::Any,false,PreETFn> pre_star(pre_star_automaton, pre_star_early_termination);
+            details::PostStarSaturation<W,C,A,ET,Trace_Type::Any,false,PostETFn> post_star(post_star_automaton, post_star_early_termination);
+            if constexpr (ET) {
+                if (pre_star.found() || post_star.found()) return solver_result::yes;
+            }
+            auto memory_bytes = [&pre_star, &post_star]() { return pre_star.memory_bytes() + post_star.memory_bytes(); };
+            Schedule schedule;
+            while(!pre_star.workset_empty() && !post_star.workset_empty()) {
+                if (governor.should_stop(memory_bytes)) return solver_result::unknown;
+                if (schedule.next_is_pre_star(std::as_const(pre_star), std::as_const(post_star))) {
+                    pre_star.step();
+                    if constexpr (ET) {
+                        if (pre_star.found()) return solver_result::yes;
+                    }
+                } else {
+                    post_star.step();
+                    if constexpr (ET) {
+                        if (post_star.found()) return solver_result::yes;
+                    }
+                }
+            }
+            // At most one of the worksets is non-empty here.
+            while (!pre_star.workset_empty() || !post_star.workset_empty()) {
                 if constexpr (ET) {
-                    if (saturation.found()) return true;
+                    if (pre_star.found() || post_star.found()) return solver_result::yes;
+                }
+                if (governor.should_stop(memory_bytes)) return solver_result::unknown;
+                if (!pre_star.workset_empty()) {
+                    pre_star.step();
+                } else {
+                    post_star.step();
                 }
-                saturation.step();
+            }
+            return pre_star.found() || post_star.found() ? solver_result::yes : solver_result::no;
+        }
+
+        // With Stats, the statistics of the saturation are written to *stats.
+        template <typename W, typename C, typename A, bool ET, Trace_Type trace_type, bool Stats, typename ETFn>
+        static bool pre_star_impl(PAutomaton<W,C,A> &automaton, const ETFn& early_termination, saturation_stats* stats,
+                                  std::shared_ptr<const CompiledPDA<W,C>> compiled = nullptr) {
+            details::pre_star_saturation_t<W,C,A,ET,trace_type,Stats,ETFn> saturation(automaton, early_termination, std::move(compiled));
+            saturation.run();
+            if constexpr (Stats) {
+                *stats = saturation.stats();
+            }
+            return saturation.found();
+        }
+
+        template <typename W, typename C, typename A, bool ET, Trace_Type trace_type = Trace_Type::Any, bool Stats = false, typename ETFn>
+        static bool post_star_any(PAutomaton<W,C,A> &automaton, const ETFn& early_termination, saturation_stats* stats = nullptr,
+                                  std::shared_ptr<const CompiledPDA<W,C>> compiled = nullptr) {
+            details::PostStarSaturation<W,C,A,ET,trace_type,Stats,ETFn> saturation(automaton, early_termination, std::move(compiled));
+            saturation.run();
+            if constexpr (Stats) {
+                *stats = saturation.stats();
             }
             return saturation.found();
         }
 
-        template<typename W, typename C, typename A, bool Enable, bool ET, typename = std::enable_if_t<Enable>>
-        static bool post_star_shortest(PAutomaton<W,C,A> &automaton, const details::early_termination_fn<W>& early_termination) {
-            details::PostStarShortestSaturation<W,C,A,Enable,ET> saturation(automaton, early_termination);
+        template<typename W, typename C, typename A, bool Enable, bool ET,
+                 template<typename,typename,typename,typename,typename> class Queue, bool Stats = false, typename ETFn, typename = std::enable_if_t<Enable>>
+        static bool post_star_shortest(PAutomaton<W,C,A> &automaton, const ETFn& early_termination, saturation_stats* stats = nullptr,
+                                       std::shared_ptr<const CompiledPDA<W,C>> compiled = nullptr) {
+            details::PostStarShortestSaturation<W,C,A,Enable,ET,Queue,Stats,ETFn> saturation(automaton, early_termination, std::move(compiled));
             while(!saturation.workset_empty()) {
                 if constexpr (ET) {
                     if (saturation.found()) break;
@@ -884,6 +2543,9 @@ namespace pdaaal {
                 saturation.step();
             }
             saturation.finalize();
+            if constexpr (Stats) {
+                *stats = saturation.stats();
+            }
             return saturation.found();
         }
 
@@ -899,8 +2561,8 @@ namespace pdaaal {
                 edges.emplace_back(path[i - 1], stack[i - 1], path[i]);
             }
 
-            auto decode_edges = [&pda](const std::deque<std::tuple<size_t, uint32_t, size_t>> &edges) -> tracestate_t {
-                tracestate_t result{std::get<0>(edges.back()), std::vector<T>()};
+            auto decode_edges = [&pda](size_t state, const std::deque<std::tuple<size_t, uint32_t, size_t>> &edges) -> tracestate_t {
+                tracestate_t result{state, std::vector<T>()};
                 auto num_labels = pda.number_of_labels();
                 for (auto it = edges.crbegin(); it != edges.crend(); ++it) {
                     auto label = std::get<1>(*it);
@@ -912,10 +2574,10 @@ namespace pdaaal {
             };
 
             std::vector<tracestate_t> trace;
-            trace.push_back(decode_edges(edges));
-            details::TraceBack tb(automaton, std::move(edges));
+            trace.push_back(decode_edges(path[0], edges));
+            details::TraceBack tb(automaton, path[0], std::move(edges));
             while (tb.next()) {
-                trace.push_back(decode_edges(tb.edges()));
+                trace.push_back(decode_edges(tb.state(), tb.edges()));
             }
             if (tb.post()) {
                 std::reverse(trace.begin(), trace.end());
@@ -953,7 +2615,7 @@ namespace pdaaal {
                 edges.emplace_back(paths[i - 1].first, stack[i - 1], paths[i].first);
             }
 
-            details::TraceBack tb(automaton, std::move(edges));
+            details::TraceBack tb(automaton, paths[0].first, std::move(edges));
             std::vector<rule_t> trace;
             while (auto rule = tb.next()) {
                 trace.emplace_back(rule.value());
@@ -964,7 +2626,7 @@ namespace pdaaal {
             start_stack.reserve(tb.edges().size());
             std::vector<size_t> start_path;
             start_path.reserve(tb.edges().size() + 1);
-            start_path.push_back(std::get<0>(tb.edges().back()));
+            start_path.push_back(tb.state());
             for (auto it = tb.edges().crbegin(); it != tb.edges().crend(); ++it) {
                 start_path.push_back(std::get<2>(*it));
                 start_stack.push_back(std::get<1>(*it));
@@ -1000,13 +2662,13 @@ namespace pdaaal {
             for (size_t i = stack.size(); i > 0; --i) {
                 initial_edges.emplace_back(paths[i - 1].first, stack[i - 1], paths[i].first);
             }
-            auto [trace, initial_stack, initial_path] = _get_trace_stack_path(initial_automaton, std::move(initial_edges));
+            auto [trace, initial_stack, initial_path] = _get_trace_stack_path(initial_automaton, paths[0].first, std::move(initial_edges));
 
             std::deque<std::tuple<size_t, uint32_t, size_t>> final_edges;
             for (size_t i = stack.size(); i > 0; --i) {
                 final_edges.emplace_back(paths[i - 1].second, stack[i - 1], paths[i].second);
             }
-            auto [trace2, final_stack, final_path] = _get_trace_stack_path(final_automaton, std::move(final_edges));
+            auto [trace2, final_stack, final_path] = _get_trace_stack_path(final_automaton, paths[0].second, std::move(final_edges));
             // Concat traces
             trace.insert(trace.end(), trace2.begin(), trace2.end());
             return std::make_tuple(trace[0].from(), trace, initial_stack, final_stack, initial_path, final_path);
@@ -1014,9 +2676,9 @@ namespace pdaaal {
 
         template <typename W, typename C, typename A>
         static std::tuple<std::vector<user_rule_t<W,C>>, std::vector<uint32_t>, std::vector<size_t>>
-        _get_trace_stack_path(const PAutomaton<W,C,A>& automaton, std::deque<std::tuple<size_t, uint32_t, size_t>>&& edges) {
+        _get_trace_stack_path(const PAutomaton<W,C,A>& automaton, size_t state, std::deque<std::tuple<size_t, uint32_t, size_t>>&& edges) {
             std::vector<user_rule_t<W,C>> trace;
-            details::TraceBack tb(automaton, std::move(edges));
+            details::TraceBack tb(automaton, state, std::move(edges));
             while(auto rule = tb.next()) {
                 trace.emplace_back(rule.value());
             }
@@ -1027,7 +2689,7 @@ namespace pdaaal {
             // Get accepting path of initial stack (and the initial stack itself - for post*)
             std::vector<uint32_t> stack; stack.reserve(tb.edges().size());
             std::vector<size_t> path; path.reserve(tb.edges().size() + 1);
-            path.push_back(std::get<0>(tb.edges().back()));
+            path.push_back(tb.state());
             for (auto it = tb.edges().crbegin(); it != tb.edges().crend(); ++it) {
                 path.push_back(std::get<2>(*it));
                 stack.push_back(std::get<1>(*it));
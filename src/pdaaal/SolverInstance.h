@@ -31,6 +31,9 @@
 #include "AbstractionPDA.h"
 #include "AbstractionPAutomaton.h"
 #include <limits>
+#include <optional>
+#include <stdexcept>
+#include <unordered_set>
 
 namespace pdaaal {
 
@@ -46,11 +49,13 @@ namespace pdaaal {
           _product(_pda, intersect_vector(initial_states, final_states), initial_nfa.empty_accept() && final_nfa.empty_accept()) { };
 
         // Returns whether an accepting state in the product automaton was reached.
-        template<bool needs_back_lookup = false>
+        // With complete=true the whole reachable product is constructed instead of stopping at the first accepting state,
+        // so find_path<Trace_Type::Shortest> can choose between all accepting paths.
+        template<bool needs_back_lookup = false, bool complete = false>
         bool initialize_product() {
             std::vector<size_t> ids(_product.states().size());
             std::iota (ids.begin(), ids.end(), 0); // Fill with 0,1,...,size-1;
-            return construct_reachable<needs_back_lookup>(ids,
+            return construct_reachable<needs_back_lookup, complete>(ids,
                                                           _swap_initial_final ? _final : _initial,
                                                           _swap_initial_final ? _initial : _final);
         }
@@ -70,9 +75,9 @@ namespace pdaaal {
             std::vector<size_t> waiting;
             for (auto [final_from, product_from] : from_states) { // Iterate through reachable 'from-states'.
                 for (const auto& [final_to,final_labels] : final.states()[final_from]->_edges) {
-                    if (final_labels.contains(label)) {
+                    if (has_matching_label(final_labels, label)) {
                         auto [fresh, product_to] = get_product_state(initial.states()[to].get(), final.states()[final_to].get());
-                        _product.add_edge(product_from, product_to, label, trace);
+                        add_matching_edges(product_from, product_to, final_labels, label, trace);
                         if (_product.has_accepting_state()) {
                             return true; // Early termination
                         }
@@ -85,6 +90,40 @@ namespace pdaaal {
             return construct_reachable(waiting, initial, final);
         }
 
+        // Fused mode: Instead of building the product automaton, each state q of the saturated automaton is tagged with
+        // the states f of the other automaton such that (q, f) is reachable in the product. Only the tags are stored,
+        // and a path through the product is found on the fly from the saturated automaton by find_path.
+        // Use initialize_fused and add_edge_fused in place of initialize_product and add_edge_product.
+        // Returns whether a pair of accepting states was reached.
+        bool initialize_fused() {
+            _fused = true;
+            _tags.assign(_pda_size, std::vector<size_t>());
+            _fused_accepting = false;
+            std::vector<std::pair<size_t,size_t>> waiting;
+            for (size_t p = 0; p < _pda_size; ++p) {
+                if (add_tag(p, p)) {
+                    waiting.emplace_back(p, p);
+                }
+            }
+            return _fused_accepting || propagate_tags(waiting);
+        }
+        // Returns whether a pair of accepting states was reached.
+        bool add_edge_fused(size_t from, uint32_t label, size_t to, trace_ptr<W> trace) {
+            if (from >= _tags.size() || _tags[from].empty()) return false; // (from, f) is not reachable for any f, so neither is the new edge.
+            const auto& other = _swap_initial_final ? _initial : _final;
+            std::vector<std::pair<size_t,size_t>> waiting;
+            for (size_t i = 0; i < _tags[from].size(); ++i) { // Index loop, since add_tag may change _tags[from] when from == to.
+                auto f_from = _tags[from][i];
+                for (const auto& [f_to, f_labels] : other.states()[f_from]->_edges) {
+                    if (has_matching_label(f_labels, label) && add_tag(to, f_to)) {
+                        if (_fused_accepting) return true; // Early termination
+                        waiting.emplace_back(to, f_to);
+                    }
+                }
+            }
+            return propagate_tags(waiting);
+        }
+
         // This is for the dual_search mode:
         bool add_initial_edge(size_t from, uint32_t label, size_t to, trace_ptr<W> trace) {
             std::vector<std::pair<size_t,size_t>> from_states;
@@ -97,9 +136,9 @@ namespace pdaaal {
             std::vector<size_t> waiting;
             for (auto [final_from, product_from] : from_states) { // Iterate through reachable 'from-states'.
                 for (const auto& [final_to,final_labels] : _final.states()[final_from]->_edges) {
-                    if (final_labels.contains(label)) {
+                    if (has_matching_label(final_labels, label)) {
                         auto [fresh, product_to] = get_product_state<true>(_initial.states()[to].get(), _final.states()[final_to].get());
-                        _product.add_edge(product_from, product_to, label, trace);
+                        add_matching_edges(product_from, product_to, final_labels, label, trace);
                         if (_product.has_accepting_state()) {
                             return true; // Early termination
                         }
@@ -122,9 +161,9 @@ namespace pdaaal {
             std::vector<size_t> waiting;
             for (auto [initial_from, product_from] : from_states) { // Iterate through reachable 'from-states'.
                 for (const auto& [initial_to,initial_labels] : _initial.states()[initial_from]->_edges) {
-                    if (initial_labels.contains(label)) {
+                    if (has_matching_label(initial_labels, label)) {
                         auto [fresh, product_to] = get_product_state<true>(_initial.states()[initial_to].get(), _final.states()[to].get());
-                        _product.add_edge(product_from, product_to, label, trace);
+                        add_matching_edges(product_from, product_to, initial_labels, label, trace);
                         if (_product.has_accepting_state()) {
                             return true; // Early termination
                         }
@@ -161,6 +200,10 @@ namespace pdaaal {
         const pda_t& pda() const {
             return _pda;
         }
+        // In fused mode, no product states or edges are added, so it only has the states of the PDA.
+        const product_automaton_t& product_automaton() const {
+            return _product;
+        }
 
         void enable_pre_star() {
             _swap_initial_final = true;
@@ -174,6 +217,13 @@ namespace pdaaal {
                 std::tuple<std::vector<path_state<abstraction>>, std::vector<uint32_t>, W>,
                 std::tuple<std::vector<path_state<abstraction>>, std::vector<uint32_t>>>
         find_path() const {
+            if (_fused) {
+                if constexpr (trace_type == Trace_Type::Shortest && is_weighted<W>) {
+                    throw std::logic_error("Shortest path is not supported in fused mode, since the product automaton is not stored.");
+                } else {
+                    return find_path_fused<abstraction>();
+                }
+            }
             if constexpr (trace_type == Trace_Type::Shortest && is_weighted<W>) { // TODO: Consider unweighted shortest path.
                 // Dijkstra.
                 struct queue_elem {
@@ -200,7 +250,7 @@ namespace pdaaal {
                 };
                 struct queue_elem_comp {
                     bool operator()(const queue_elem &lhs, const queue_elem &rhs){
-                        C less;
+                        weight_compare_t<W,C> less;
                         return less(rhs.weight, lhs.weight); // Used in a max-heap, so swap arguments to make it a min-heap.
                     }
                 };
@@ -222,7 +272,7 @@ namespace pdaaal {
                         const queue_elem* p = &current;
                         while (p->stack_index > 0) {
                             path[p->stack_index] = get_original_ids(p->state).first;
-                            label_stack[p->stack_index - 1] = p->label;
+                            label_stack[p->stack_index - 1] = concrete_label(p->back_pointer->state, p->label, p->state);
                             p = p->back_pointer;
                         }
                         if constexpr (abstraction) {
@@ -248,7 +298,7 @@ namespace pdaaal {
                     pointers.push_back(std::move(u_pointer));
                     for (const auto &[to,labels] : _product.states()[current.state]->_edges) {
                         if (!labels.empty()) {
-                            auto label = std::min_element(labels.begin(), labels.end(), [](const auto& a, const auto& b){ return C{}(a.second.second, b.second.second); });
+                            auto label = std::min_element(labels.begin(), labels.end(), [](const auto& a, const auto& b){ return weight_compare_t<W,C>{}(a.second.second, b.second.second); });
                             search_queue.emplace(add(current.weight, label->second.second), to, label->first, current.stack_index + 1, pointer);
                         }
                     }
@@ -289,7 +339,7 @@ namespace pdaaal {
                     }
                     for (const auto &[to,labels] : _product.states()[current]->_edges) {
                         if (!labels.empty() && seen.emplace(to).second) {
-                            uint32_t label = labels[0].first;
+                            uint32_t label = concrete_label(current, labels[0].first, to);
                             if (_product.states()[to]->_accepting) {
                                 if constexpr (abstraction) {
                                     path[stack_index + 1] = get_original_ids(to).to_pair();
@@ -308,31 +358,215 @@ namespace pdaaal {
         }
 
     private:
+        static constexpr auto epsilon = product_automaton_t::epsilon;
+        static constexpr auto wildcard = product_automaton_t::wildcard;
+
+        // Whether an edge label set has a label that matches label. A wildcard (on either side) matches any label except epsilon.
+        template<typename Labels>
+        static bool has_matching_label(const Labels& labels, uint32_t label) {
+            if (label != wildcard) {
+                return labels.contains(label) || (label != epsilon && labels.contains(wildcard));
+            }
+            return std::any_of(labels.begin(), labels.end(), [](const auto& elem) { return elem.first != epsilon; });
+        }
+        // Add a product edge for each label in labels that matches label (see has_matching_label).
+        template<typename Labels>
+        void add_matching_edges(size_t product_from, size_t product_to, const Labels& labels, uint32_t label, trace_ptr<W> trace) {
+            if (label != wildcard) {
+                _product.add_edge(product_from, product_to, label, trace);
+                return;
+            }
+            for (const auto& [l, _] : labels) {
+                if (l != epsilon) {
+                    _product.add_edge(product_from, product_to, l, trace);
+                }
+            }
+        }
+        // A wildcard in the product means that both automata accept any label here. We choose a label that the rule in the trace
+        // of one of the two wildcard edges can be applied to (see PAutomaton::concrete_label), or label 0 if neither has a trace.
+        uint32_t concrete_label(size_t from, uint32_t label, size_t to) const {
+            auto [a_from, b_from] = get_original_ids(from);
+            auto [a_to, b_to] = get_original_ids(to);
+            return concrete_label(a_from, b_from, label, a_to, b_to);
+        }
+        uint32_t concrete_label(size_t a_from, size_t b_from, uint32_t label, size_t a_to, size_t b_to) const {
+            if (label != wildcard) return label;
+            const auto& a = _swap_initial_final ? _final : _initial;
+            const auto& b = _swap_initial_final ? _initial : _final;
+            if (auto l = a.concrete_label(a_from, label, a_to); l != wildcard) return l;
+            if (auto l = b.concrete_label(b_from, label, b_to); l != wildcard) return l;
+            return 0;
+        }
+        // A label that matches both edge label sets (see has_matching_label), or std::nullopt if there is none.
+        template<typename Labels>
+        static std::optional<uint32_t> common_label(const Labels& a_labels, const Labels& b_labels) {
+            for (const auto& [label, _] : a_labels) {
+                if (!has_matching_label(b_labels, label)) continue;
+                if (label != wildcard) return label;
+                for (const auto& [b_label, b_trace] : b_labels) { // Any non-epsilon label of b matches the wildcard.
+                    if (b_label != epsilon) return b_label;
+                }
+            }
+            return std::nullopt;
+        }
+
+        // Tag state q of the saturated automaton with state f of the other automaton. Returns whether the tag is new.
+        bool add_tag(size_t q, size_t f) {
+            if (q >= _tags.size()) {
+                _tags.resize(q + 1); // The saturation (post*) adds states.
+            }
+            auto& tags = _tags[q];
+            auto lb = std::lower_bound(tags.begin(), tags.end(), f);
+            if (lb != tags.end() && *lb == f) return false;
+            tags.insert(lb, f);
+            const auto& saturated = _swap_initial_final ? _final : _initial;
+            const auto& other = _swap_initial_final ? _initial : _final;
+            if (saturated.states()[q]->_accepting && other.states()[f]->_accepting) {
+                _fused_accepting = true;
+            }
+            return true;
+        }
+        // Follow the existing edges from the newly tagged pairs in waiting. Returns whether a pair of accepting states was reached.
+        bool propagate_tags(std::vector<std::pair<size_t,size_t>>& waiting) {
+            const auto& saturated = _swap_initial_final ? _final : _initial;
+            const auto& other = _swap_initial_final ? _initial : _final;
+            while (!waiting.empty()) {
+                auto [q, f] = waiting.back();
+                waiting.pop_back();
+                for (const auto& [q_to, q_labels] : saturated.states()[q]->_edges) {
+                    for (const auto& [f_to, f_labels] : other.states()[f]->_edges) {
+                        if (common_label(q_labels, f_labels) && add_tag(q_to, f_to)) {
+                            if (_fused_accepting) return true; // Early termination
+                            waiting.emplace_back(q_to, f_to);
+                        }
+                    }
+                }
+            }
+            return _fused_accepting;
+        }
+        // Depth-first search for a path to a pair of accepting states, following only pairs that are tagged.
+        template<bool abstraction>
+        std::tuple<std::vector<path_state<abstraction>>, std::vector<uint32_t>> find_path_fused() const {
+            const auto& saturated = _swap_initial_final ? _final : _initial;
+            const auto& other = _swap_initial_final ? _initial : _final;
+            auto is_tagged = [this](size_t q, size_t f) {
+                return q < _tags.size() && std::binary_search(_tags[q].begin(), _tags[q].end(), f);
+            };
+            auto make_state = [](size_t q, size_t f) -> path_state<abstraction> {
+                if constexpr (abstraction) {
+                    return std::make_pair(q, f);
+                } else {
+                    return q;
+                }
+            };
+            struct node_t {
+                size_t q, f, parent;
+                uint32_t label;
+            };
+            constexpr auto no_parent = std::numeric_limits<size_t>::max();
+            std::vector<node_t> nodes;
+            std::vector<size_t> waiting;
+            std::unordered_set<std::pair<size_t,size_t>, boost::hash<std::pair<size_t,size_t>>> seen;
+            for (size_t p = 0; p < _pda_size; ++p) {
+                seen.emplace(p, p);
+                waiting.push_back(nodes.size());
+                nodes.push_back(node_t{p, p, no_parent, 0});
+            }
+            while (!waiting.empty()) {
+                auto id = waiting.back();
+                waiting.pop_back();
+                auto q = nodes[id].q;
+                auto f = nodes[id].f;
+                if (saturated.states()[q]->_accepting && other.states()[f]->_accepting) {
+                    std::vector<path_state<abstraction>> path;
+                    std::vector<uint32_t> label_stack;
+                    for (; id != no_parent; id = nodes[id].parent) {
+                        path.push_back(make_state(nodes[id].q, nodes[id].f));
+                        if (nodes[id].parent != no_parent) {
+                            label_stack.push_back(nodes[id].label);
+                        }
+                    }
+                    std::reverse(path.begin(), path.end());
+                    std::reverse(label_stack.begin(), label_stack.end());
+                    return std::make_tuple(path, label_stack);
+                }
+                for (const auto& [q_to, q_labels] : saturated.states()[q]->_edges) {
+                    for (const auto& [f_to, f_labels] : other.states()[f]->_edges) {
+                        if (!is_tagged(q_to, f_to) || seen.count(std::make_pair(q_to, f_to)) > 0) continue;
+                        if (auto l = common_label(q_labels, f_labels); l) {
+                            seen.emplace(q_to, f_to);
+                            waiting.push_back(nodes.size());
+                            nodes.push_back(node_t{q_to, f_to, id, concrete_label(q, f, l.value(), q_to, f_to)});
+                        }
+                    }
+                }
+            }
+            return std::make_tuple(std::vector<path_state<abstraction>>(), std::vector<uint32_t>());
+        }
 
         // Returns whether an accepting state in the product automaton was reached.
-        template<bool needs_back_lookup = false>
+        // For each product state, the edges of the final state are indexed by label (in _join_index), so each label on an initial edge
+        // only visits the final edges with that label (or a wildcard). The matches are grouped by final edge, so each product state
+        // is looked up once per pair of edges. The scratch buffers are reused between calls.
+        template<bool needs_back_lookup = false, bool complete = false>
         bool construct_reachable(std::vector<size_t>& waiting, const automaton_t& initial, const automaton_t& final) {
             while (!waiting.empty()) {
                 size_t top = waiting.back();
                 waiting.pop_back();
                 auto [i_from,f_from] = get_original_ids(top);
+                _join_edges.clear();
+                _join_index.clear();
+                for (const auto& f_edge : final.states()[f_from]->_edges) {
+                    for (const auto& [label, _] : f_edge.second) {
+                        _join_index.emplace_back(label, _join_edges.size());
+                    }
+                    _join_edges.push_back(&f_edge);
+                }
+                std::sort(_join_index.begin(), _join_index.end());
+                auto label_range = [this](uint32_t label) {
+                    return std::equal_range(_join_index.begin(), _join_index.end(), std::make_pair(label, size_t(0)),
+                                            [](const auto& a, const auto& b) { return a.first < b.first; });
+                };
+                const auto [wildcard_begin, wildcard_end] = label_range(wildcard);
                 for (const auto& [i_to,i_labels] : initial.states()[i_from]->_edges) {
-                    for (const auto& [f_to,f_labels] : final.states()[f_from]->_edges) {
-                        std::vector<typename decltype(i_labels)::value_type> labels;
-                        std::set_intersection(i_labels.begin(), i_labels.end(), f_labels.begin(), f_labels.end(), std::back_inserter(labels));
-                        if (!labels.empty()) {
-                            auto [fresh, to_id] = get_product_state<needs_back_lookup>(initial.states()[i_to].get(), final.states()[f_to].get());
-                            for (const auto & [label, trace] : labels) {
-                                _product.add_edge(top, to_id, label, trace);
-                            }
-                            if (_product.has_accepting_state()) {
-                                return true; // Early termination
+                    _join_matches.clear();
+                    for (const auto& [label, trace] : i_labels) {
+                        if (label == wildcard) {
+                            // A wildcard matches the concrete labels on the other side that are not on this side (those are matched below).
+                            for (auto it = _join_index.begin(); it != wildcard_begin; ++it) {
+                                if (!i_labels.contains(it->first)) {
+                                    _join_matches.emplace_back(it->second, it->first, trace);
+                                }
                             }
-                            if (fresh) {
-                                waiting.push_back(to_id);
+                        }
+                        auto [begin, end] = label_range(label);
+                        for (auto it = begin; it != end; ++it) {
+                            _join_matches.emplace_back(it->second, label, trace);
+                        }
+                        if (label != epsilon && label != wildcard) {
+                            // A wildcard on the other side matches this label, unless that edge also has the label itself.
+                            for (auto it = wildcard_begin; it != wildcard_end; ++it) {
+                                if (!_join_edges[it->second]->second.contains(label)) {
+                                    _join_matches.emplace_back(it->second, label, trace);
+                                }
                             }
                         }
                     }
+                    if (_join_matches.empty()) continue;
+                    std::stable_sort(_join_matches.begin(), _join_matches.end(), [](const auto& a, const auto& b) { return std::get<0>(a) < std::get<0>(b); });
+                    for (size_t m = 0; m < _join_matches.size();) {
+                        auto e = std::get<0>(_join_matches[m]);
+                        auto [fresh, to_id] = get_product_state<needs_back_lookup>(initial.states()[i_to].get(), final.states()[_join_edges[e]->first].get());
+                        for (; m < _join_matches.size() && std::get<0>(_join_matches[m]) == e; ++m) {
+                            _product.add_edge(top, to_id, std::get<1>(_join_matches[m]), std::get<2>(_join_matches[m]));
+                        }
+                        if (!complete && _product.has_accepting_state()) {
+                            return true; // Early termination
+                        }
+                        if (fresh) {
+                            waiting.push_back(to_id);
+                        }
+                    }
                 }
             }
             return _product.has_accepting_state();
@@ -398,6 +632,12 @@ namespace pdaaal {
         ptrie::set_stable<pair_size_t> _id_map;
         std::vector<std::vector<std::pair<size_t,size_t>>> _id_fast_lookup; // maps initial_state -> (final_state, product_state)
         std::vector<std::vector<std::pair<size_t,size_t>>> _id_fast_lookup_back; // maps final_state -> (initial_state, product_state)  Only used in dual_search
+        std::vector<const typename decltype(state_t::_edges)::value_type*> _join_edges; // Scratch buffer for construct_reachable: the edges of the final state.
+        std::vector<std::pair<uint32_t,size_t>> _join_index; // Scratch buffer for construct_reachable: (label, index of final edge) sorted by label.
+        std::vector<std::tuple<size_t,uint32_t,trace_ptr<W>>> _join_matches; // Scratch buffer for construct_reachable: (index of final edge, label, trace)
+        bool _fused = false;
+        bool _fused_accepting = false;
+        std::vector<std::vector<size_t>> _tags; // Only used in fused mode. Maps state of saturated automaton -> sorted states of the other automaton.
     };
 
     template <typename T, typename W, typename C, typename A>
@@ -36,6 +36,8 @@
 #include <optional>
 #include <functional>
 
+#include "weight_simd.h"
+
 namespace pdaaal {
 
     template<typename W, typename = void> struct zero;
@@ -104,6 +106,37 @@ namespace pdaaal {
     };
 
 
+    // Same order as std::less<W>, but with a SIMD kernel for the lexicographic compare of std::array weights where available.
+    // std::less cannot be specialized for arrays of built-in types, so the solvers use this in place of std::less<W> (see weight_compare_t).
+    template<typename W>
+    struct weight_less {
+        constexpr bool operator()(const W& lhs, const W& rhs) const {
+            return std::less<W>()(lhs, rhs);
+        }
+    };
+
+    template<typename Inner, std::size_t N>
+    struct weight_less<std::array<Inner, N>> {
+        constexpr bool operator()(const std::array<Inner, N>& lhs, const std::array<Inner, N>& rhs) const {
+#ifdef PDAAAL_SIMD_WEIGHTS
+            if constexpr (details::has_simd_kernel<Inner, N>) {
+                if (!__builtin_is_constant_evaluated()) {
+                    return details::simd_less<Inner, N>(lhs.data(), rhs.data());
+                }
+            }
+#endif
+            for (size_t i = 0; i < N; ++i) { // Same as std::lexicographical_compare, which is not constexpr in C++17.
+                if (lhs[i] < rhs[i]) return true;
+                if (rhs[i] < lhs[i]) return false;
+            }
+            return false;
+        }
+    };
+
+    // The comparator used internally for weights. weight_less gives the same order as std::less<W>, so it replaces the default.
+    template<typename W, typename C>
+    using weight_compare_t = std::conditional_t<std::is_same_v<C, std::less<W>>, weight_less<W>, C>;
+
     template<typename Inner>
     struct zero<std::vector<Inner>, std::enable_if_t<has_zero_v<Inner>>> {
         constexpr std::vector<Inner> operator()() const {
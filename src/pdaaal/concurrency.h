@@ -0,0 +1,220 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   concurrency.h
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#ifndef PDAAAL_CONCURRENCY_H
+#define PDAAAL_CONCURRENCY_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <unordered_set>
+#include <cassert>
+
+namespace pdaaal::details {
+
+    // Number of threads to use, when the user does not specify it.
+    inline size_t default_thread_count() {
+        auto n = std::thread::hardware_concurrency();
+        return n == 0 ? 1 : n;
+    }
+
+    // A fixed number of mutexes, where an index is mapped to one of them.
+    // Used to guard per-state data (e.g. _rel[q]) without a mutex per state.
+    class striped_mutex {
+    public:
+        explicit striped_mutex(size_t stripes) : _stripes(stripes), _mutexes(std::make_unique<std::mutex[]>(stripes)) {
+            assert(stripes > 0);
+        }
+        std::mutex& operator[](size_t index) {
+            return _mutexes[index % _stripes];
+        }
+    private:
+        const size_t _stripes;
+        std::unique_ptr<std::mutex[]> _mutexes;
+    };
+
+    // Set split into independently locked shards. insert() returns true iff the element was not already in the set.
+    template <typename T, typename Hash = std::hash<T>>
+    class concurrent_set {
+        struct shard_t {
+            std::mutex _lock;
+            std::unordered_set<T,Hash> _set;
+        };
+    public:
+        explicit concurrent_set(size_t shards) : _n_shards(shards), _shards(std::make_unique<shard_t[]>(shards)) {
+            assert(shards > 0);
+        }
+        bool insert(const T& elem) {
+            auto& shard = _shards[_hash(elem) % _n_shards];
+            std::lock_guard<std::mutex> guard(shard._lock);
+            return shard._set.insert(elem).second;
+        }
+        bool contains(const T& elem) {
+            auto& shard = _shards[_hash(elem) % _n_shards];
+            std::lock_guard<std::mutex> guard(shard._lock);
+            return shard._set.count(elem) > 0;
+        }
+        [[nodiscard]] size_t size() const { // Not synchronized. Only use when no other thread is inserting.
+            size_t result = 0;
+            for (size_t i = 0; i < _n_shards; ++i) {
+                result += _shards[i]._set.size();
+            }
+            return result;
+        }
+    private:
+        const Hash _hash{};
+        const size_t _n_shards;
+        std::unique_ptr<shard_t[]> _shards;
+    };
+
+    // Workset with one double-ended queue per thread. A thread pushes and pops at the back of its own queue,
+    // and when it runs empty, it steals from the front of the other threads' queues.
+    // Termination: _pending counts elements that are either in a queue or currently being processed,
+    // so a worker must call done() after processing a popped element (and after pushing the elements it generated).
+    // A worker that finds no element calls wait(), which blocks until an element is pushed, the work is finished, or stop() is called.
+    template <typename T>
+    class work_stealing_workset {
+        struct queue_t {
+            std::mutex _lock;
+            std::deque<T> _elems;
+        };
+    public:
+        explicit work_stealing_workset(size_t n_threads) : _n_threads(n_threads), _queues(std::make_unique<queue_t[]>(n_threads)) {
+            assert(n_threads > 0);
+        }
+
+        template <typename... Args>
+        void emplace(size_t thread, Args&&... args) {
+            auto& queue = _queues[thread];
+            _pending.fetch_add(1, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> guard(queue._lock);
+                queue._elems.emplace_back(std::forward<Args>(args)...);
+            }
+            _queued.fetch_add(1);
+            if (_n_waiting.load() > 0) { // Only take the idle lock if some worker may be waiting.
+                std::lock_guard<std::mutex> guard(_idle_lock);
+                _idle.notify_one();
+            }
+        }
+
+        bool pop(size_t thread, T& result) {
+            {
+                auto& queue = _queues[thread];
+                std::lock_guard<std::mutex> guard(queue._lock);
+                if (!queue._elems.empty()) {
+                    result = queue._elems.back();
+                    queue._elems.pop_back();
+                    _queued.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            for (size_t i = 1; i < _n_threads; ++i) { // Steal
+                auto& queue = _queues[(thread + i) % _n_threads];
+                std::lock_guard<std::mutex> guard(queue._lock);
+                if (!queue._elems.empty()) {
+                    result = queue._elems.front();
+                    queue._elems.pop_front();
+                    _queued.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void done() {
+            if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) { // Finished, so wake up all waiting workers.
+                std::lock_guard<std::mutex> guard(_idle_lock);
+                _idle.notify_all();
+            }
+        }
+
+        // Block until there may be an element to pop, the work is finished, or stop() was called.
+        void wait() {
+            std::unique_lock<std::mutex> lock(_idle_lock);
+            _n_waiting.fetch_add(1);
+            _idle.wait(lock, [this]() { return _queued.load() > 0 || finished() || _stopped; });
+            _n_waiting.fetch_sub(1);
+        }
+        // Wake up all waiting workers, and make wait() return immediately from now on. Used for early termination.
+        void stop() {
+            std::lock_guard<std::mutex> guard(_idle_lock);
+            _stopped = true;
+            _idle.notify_all();
+        }
+
+        [[nodiscard]] bool finished() const {
+            return _pending.load(std::memory_order_acquire) == 0;
+        }
+
+        [[nodiscard]] size_t n_threads() const { return _n_threads; }
+
+    private:
+        const size_t _n_threads;
+        std::unique_ptr<queue_t[]> _queues;
+        std::atomic<size_t> _pending{0};
+        std::atomic<size_t> _queued{0}; // Elements in the queues, i.e. _pending without those being processed.
+        std::atomic<size_t> _n_waiting{0};
+        std::mutex _idle_lock;
+        std::condition_variable _idle;
+        bool _stopped = false; // Guarded by _idle_lock.
+    };
+
+    // Calls fn(v[i]) for i < n, while other threads may append to v when holding lock.
+    // Each element is copied under the lock, and fn is called without it.
+    template <typename T, typename Fn>
+    void for_each_prefix(std::mutex& lock, const std::vector<T>& v, size_t n, Fn&& fn) {
+        for (size_t i = 0; i < n; ++i) {
+            T elem;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                elem = v[i];
+            }
+            fn(elem);
+        }
+    }
+
+    // Run fn(thread_id) on n_threads threads (thread 0 is the calling thread) and wait for all to finish.
+    template <typename Fn>
+    void run_threads(size_t n_threads, Fn&& fn) {
+        std::vector<std::thread> threads;
+        threads.reserve(n_threads - 1);
+        for (size_t i = 1; i < n_threads; ++i) {
+            threads.emplace_back([&fn, i](){ fn(i); });
+        }
+        fn(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+}
+
+#endif //PDAAAL_CONCURRENCY_H
@@ -0,0 +1,167 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   flat_edge_set.h
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#ifndef PDAAAL_FLAT_EDGE_SET_H
+#define PDAAAL_FLAT_EDGE_SET_H
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <vector>
+#include <cassert>
+
+namespace pdaaal::details {
+
+    // Hash set of (from, label, to) triples used for membership tests during saturation.
+    // Each triple is packed into two 64-bit words and stored inline in a power-of-two sized table with linear probing,
+    // so there is no allocation per element. Removal uses backward shift deletion, so no tombstones are left in the table.
+    class flat_edge_set {
+        struct key_t {
+            uint64_t _from = empty_from;
+            uint64_t _to_label = 0; // (to << 32) | label
+        };
+        static constexpr uint64_t empty_from = std::numeric_limits<uint64_t>::max();
+        static constexpr size_t min_capacity = 16;
+    public:
+        flat_edge_set() = default;
+        // Pre-size the table to hold expected_size elements without rehashing.
+        explicit flat_edge_set(size_t expected_size) {
+            reserve(expected_size);
+        }
+
+        // Returns true iff the edge was not already in the set.
+        bool emplace(size_t from, uint32_t label, size_t to) {
+            assert(from != empty_from);
+            assert(to <= std::numeric_limits<uint32_t>::max());
+            if ((_size + 1) * 4 > _table.size() * 3) { // Max load factor 0.75
+                rehash(std::max(min_capacity, _table.size() * 2));
+            }
+            key_t key{from, (static_cast<uint64_t>(to) << 32) | label};
+            for (size_t i = hash(key) & _mask; ; i = (i + 1) & _mask) {
+                auto& slot = _table[i];
+                if (slot._from == empty_from) {
+                    slot = key;
+                    ++_size;
+                    return true;
+                }
+                if (slot._from == key._from && slot._to_label == key._to_label) {
+                    return false;
+                }
+            }
+        }
+
+        [[nodiscard]] bool contains(size_t from, uint32_t label, size_t to) const {
+            if (_size == 0) return false;
+            key_t key{from, (static_cast<uint64_t>(to) << 32) | label};
+            for (size_t i = hash(key) & _mask; ; i = (i + 1) & _mask) {
+                const auto& slot = _table[i];
+                if (slot._from == empty_from) {
+                    return false;
+                }
+                if (slot._from == key._from && slot._to_label == key._to_label) {
+                    return true;
+                }
+            }
+        }
+
+        // Returns true iff the edge was in the set.
+        bool erase(size_t from, uint32_t label, size_t to) {
+            if (_size == 0) return false;
+            key_t key{from, (static_cast<uint64_t>(to) << 32) | label};
+            size_t i = hash(key) & _mask;
+            for (; ; i = (i + 1) & _mask) {
+                const auto& slot = _table[i];
+                if (slot._from == empty_from) {
+                    return false;
+                }
+                if (slot._from == key._from && slot._to_label == key._to_label) {
+                    break;
+                }
+            }
+            // Move later elements of the probe sequence back into the hole, unless their home slot is after the hole.
+            for (size_t j = (i + 1) & _mask; _table[j]._from != empty_from; j = (j + 1) & _mask) {
+                size_t home = hash(_table[j]) & _mask;
+                if (((j - home) & _mask) >= ((j - i) & _mask)) {
+                    _table[i] = _table[j];
+                    i = j;
+                }
+            }
+            _table[i] = key_t{};
+            --_size;
+            return true;
+        }
+
+        void reserve(size_t expected_size) {
+            size_t capacity = min_capacity;
+            while (expected_size * 4 > capacity * 3) {
+                capacity *= 2;
+            }
+            if (capacity > _table.size()) {
+                rehash(capacity);
+            }
+        }
+
+        [[nodiscard]] size_t size() const { return _size; }
+        [[nodiscard]] bool empty() const { return _size == 0; }
+        [[nodiscard]] size_t memory_bytes() const { return _table.capacity() * sizeof(key_t); }
+
+    private:
+        std::vector<key_t> _table;
+        size_t _mask = 0;
+        size_t _size = 0;
+
+        static size_t hash(const key_t& key) {
+            // Combine the two words and mix with the MurmurHash3 64-bit finalizer.
+            uint64_t h = key._from * 0x9E3779B97F4A7C15ULL ^ key._to_label;
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDULL;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53ULL;
+            h ^= h >> 33;
+            return static_cast<size_t>(h);
+        }
+
+        void rehash(size_t capacity) {
+            assert((capacity & (capacity - 1)) == 0);
+            std::vector<key_t> old(capacity);
+            std::swap(old, _table);
+            _mask = capacity - 1;
+            for (const auto& key : old) {
+                if (key._from == empty_from) continue;
+                size_t i = hash(key) & _mask;
+                while (_table[i]._from != empty_from) {
+                    i = (i + 1) & _mask;
+                }
+                _table[i] = key;
+            }
+        }
+    };
+
+}
+
+#endif //PDAAAL_FLAT_EDGE_SET_H
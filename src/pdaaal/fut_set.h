@@ -120,6 +120,7 @@ namespace pdaaal::fut {
 
             const_iterator find(const Head &head) const { return elems.find(head); }
             iterator find(const Head &head) { return elems.find(head); }
+            iterator erase(iterator pos) { return elems.erase(pos); }
 
         private:
             container_type elems;
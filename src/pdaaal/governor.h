@@ -0,0 +1,122 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   governor.h
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#ifndef PDAAAL_GOVERNOR_H
+#define PDAAAL_GOVERNOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+
+namespace pdaaal {
+
+    // Result of a solve that may be stopped by a governor before it has an answer.
+    enum class solver_result {
+        no,
+        yes,
+        unknown
+    };
+
+    // Resource limits for a solve: a wall-clock deadline, an external cancellation flag and a memory budget.
+    // The solver calls should_stop() once per saturation step. The limits are only checked every check_interval calls,
+    // so the cost per step is an increment and a branch. Once a limit is hit, should_stop() keeps returning true.
+    class governor {
+    public:
+        using clock = std::chrono::steady_clock;
+        enum class reason_t {
+            none,
+            deadline,
+            cancelled,
+            memory
+        };
+        static constexpr size_t check_interval = 64; // Must be a power of 2.
+
+        governor() = default;
+
+        governor& set_deadline(clock::time_point deadline) {
+            _deadline = deadline;
+            return *this;
+        }
+        template <typename Rep, typename Period>
+        governor& set_timeout(std::chrono::duration<Rep,Period> timeout) {
+            return set_deadline(clock::now() + std::chrono::duration_cast<clock::duration>(timeout));
+        }
+        // The solve stops when another thread sets *flag to true. The flag must outlive the solve.
+        governor& set_cancel_flag(const std::atomic<bool>* flag) {
+            _cancel = flag;
+            return *this;
+        }
+        // Limit on the estimated memory (in bytes) of the automaton edges, traces and the saturation's edge set.
+        governor& set_memory_budget(size_t bytes) {
+            _memory_budget = bytes;
+            return *this;
+        }
+
+        // memory_bytes() gives the current memory estimate. It is only called when the limits are checked.
+        template <typename MemoryFn>
+        bool should_stop(MemoryFn&& memory_bytes) {
+            if (_reason != reason_t::none) return true;
+            if ((++_calls & (check_interval - 1)) != 0) return false;
+            if (_cancel != nullptr && _cancel->load(std::memory_order_relaxed)) {
+                _reason = reason_t::cancelled;
+            } else if (_memory_budget != unlimited && memory_bytes() > _memory_budget) {
+                _reason = reason_t::memory;
+            } else if (_deadline != clock::time_point::max() && clock::now() >= _deadline) {
+                _reason = reason_t::deadline;
+            }
+            return _reason != reason_t::none;
+        }
+
+        [[nodiscard]] bool stopped() const { return _reason != reason_t::none; }
+        [[nodiscard]] reason_t reason() const { return _reason; }
+
+        // Clear the stop reason (but keep the limits), e.g. to reuse the governor after raising a limit.
+        void reset() {
+            _reason = reason_t::none;
+            _calls = 0;
+        }
+
+    private:
+        static constexpr size_t unlimited = std::numeric_limits<size_t>::max();
+        clock::time_point _deadline = clock::time_point::max();
+        const std::atomic<bool>* _cancel = nullptr;
+        size_t _memory_budget = unlimited;
+        size_t _calls = 0;
+        reason_t _reason = reason_t::none;
+    };
+
+    namespace details {
+        // Governor that never stops the solve, so the checks compile away.
+        struct no_governor {
+            template <typename MemoryFn>
+            constexpr bool should_stop(MemoryFn&&) const { return false; }
+        };
+    }
+
+}
+
+#endif //PDAAAL_GOVERNOR_H
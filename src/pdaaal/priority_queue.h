@@ -0,0 +1,219 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   priority_queue.h
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#ifndef PDAAAL_PRIORITY_QUEUE_H
+#define PDAAAL_PRIORITY_QUEUE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <queue>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cassert>
+
+#include "Weight.h"
+
+namespace pdaaal {
+
+    // Priority queue policies for the workset of shortest-trace post*.
+    // A queue holds (weight, key, value) elements, where the comparator C orders the weights.
+    // push(weight, key, value) is called whenever a better weight for key is found, and pop() returns an element with minimal weight.
+    // A queue may keep the outdated elements of a key (lazy deletion), so the caller must skip elements that are no longer current.
+
+    // Binary heap with lazy deletion. Works for any weight type.
+    template <typename W, typename C, typename Key, typename Value, typename KeyHash>
+    class binary_heap_queue {
+        struct elem_t {
+            W _weight;
+            Key _key;
+            Value _value;
+            elem_t(const W& weight, const Key& key, const Value& value) : _weight(weight), _key(key), _value(value) {};
+        };
+        struct elem_comp {
+            bool operator()(const elem_t& lhs, const elem_t& rhs) const {
+                const weight_compare_t<W,C> less;
+                return less(rhs._weight, lhs._weight); // Used in a max-heap, so swap arguments to make it a min-heap.
+            }
+        };
+    public:
+        void push(const W& weight, const Key& key, const Value& value) {
+            _heap.emplace(weight, key, value);
+        }
+        std::tuple<W,Key,Value> pop() {
+            auto elem = _heap.top();
+            _heap.pop();
+            return {elem._weight, elem._key, elem._value};
+        }
+        [[nodiscard]] bool empty() const { return _heap.empty(); }
+        [[nodiscard]] size_t size() const { return _heap.size(); }
+    private:
+        std::priority_queue<elem_t, std::vector<elem_t>, elem_comp> _heap;
+    };
+
+    // Binary heap with decrease-key. A key is in the queue at most once, so no outdated elements are stored or popped.
+    // Works for any weight type, including lexicographic std::array weights.
+    template <typename W, typename C, typename Key, typename Value, typename KeyHash>
+    class addressable_heap_queue {
+        struct elem_t {
+            W _weight;
+            Key _key;
+            Value _value;
+        };
+    public:
+        void push(const W& weight, const Key& key, const Value& value) {
+            auto [it, fresh] = _position.emplace(key, _heap.size());
+            if (fresh) {
+                _heap.push_back(elem_t{weight, key, value});
+                sift_up(_heap.size() - 1);
+            } else if (_less(weight, _heap[it->second]._weight)) {
+                auto& elem = _heap[it->second];
+                elem._weight = weight;
+                elem._value = value;
+                sift_up(it->second);
+            }
+        }
+        std::tuple<W,Key,Value> pop() {
+            assert(!_heap.empty());
+            auto top = std::move(_heap.front());
+            _position.erase(top._key);
+            if (_heap.size() > 1) {
+                move_to(0, std::move(_heap.back()));
+                _heap.pop_back();
+                sift_down(0);
+            } else {
+                _heap.pop_back();
+            }
+            return {std::move(top._weight), std::move(top._key), std::move(top._value)};
+        }
+        [[nodiscard]] bool empty() const { return _heap.empty(); }
+        [[nodiscard]] size_t size() const { return _heap.size(); }
+    private:
+        const weight_compare_t<W,C> _less{};
+        std::vector<elem_t> _heap;
+        std::unordered_map<Key, size_t, KeyHash> _position;
+
+        void move_to(size_t i, elem_t&& elem) {
+            _position[elem._key] = i;
+            _heap[i] = std::move(elem);
+        }
+        void sift_up(size_t i) {
+            auto elem = std::move(_heap[i]);
+            while (i > 0) {
+                auto parent = (i - 1) / 2;
+                if (!_less(elem._weight, _heap[parent]._weight)) break;
+                move_to(i, std::move(_heap[parent]));
+                i = parent;
+            }
+            move_to(i, std::move(elem));
+        }
+        void sift_down(size_t i) {
+            auto elem = std::move(_heap[i]);
+            const auto n = _heap.size();
+            while (true) {
+                auto child = 2 * i + 1;
+                if (child >= n) break;
+                if (child + 1 < n && _less(_heap[child + 1]._weight, _heap[child]._weight)) ++child;
+                if (!_less(_heap[child]._weight, elem._weight)) break;
+                move_to(i, std::move(_heap[child]));
+                i = child;
+            }
+            move_to(i, std::move(elem));
+        }
+    };
+
+    // Bucket queue (Dial) for small non-negative integer weights ordered by std::less (or weight_less).
+    // Push and pop take amortized constant time, but memory is linear in the range of weights in the queue at the same time.
+    // The buckets form a ring indexed by weight modulo the (power of two) number of buckets, so a drained bucket is reused
+    // for a larger weight, and a weight below the current minimum only moves _base (unless the range no longer fits).
+    // Uses lazy deletion like binary_heap_queue.
+    template <typename W, typename C, typename Key, typename Value, typename KeyHash>
+    class bucket_queue {
+        static_assert(std::is_integral_v<W>, "bucket_queue requires integer weights.");
+        static_assert(std::is_same_v<C, std::less<W>> || std::is_same_v<C, std::less<>> || std::is_same_v<C, weight_less<W>>,
+                      "bucket_queue requires weights ordered by std::less.");
+        static constexpr size_t min_buckets = 16;
+    public:
+        void push(const W& weight, const Key& key, const Value& value) {
+            assert(weight >= 0);
+            auto w = static_cast<size_t>(weight);
+            if (_size == 0) {
+                _base = w;
+                _max = w;
+            }
+            auto low = std::min(_base, w);
+            auto high = std::max(_max, w);
+            if (high - low >= _buckets.size()) {
+                grow(high - low + 1);
+            }
+            _base = low; // Weights are usually non-decreasing, but we support going below the current minimum.
+            _max = high;
+            _buckets[w & (_buckets.size() - 1)].emplace_back(key, value);
+            ++_size;
+        }
+        std::tuple<W,Key,Value> pop() {
+            assert(_size > 0);
+            const auto mask = _buckets.size() - 1;
+            while (_buckets[_base & mask].empty()) {
+                ++_base;
+            }
+            auto& bucket = _buckets[_base & mask];
+            auto [key, value] = bucket.back();
+            bucket.pop_back();
+            --_size;
+            return {static_cast<W>(_base), key, value};
+        }
+        [[nodiscard]] bool empty() const { return _size == 0; }
+        [[nodiscard]] size_t size() const { return _size; }
+    private:
+        std::vector<std::vector<std::pair<Key,Value>>> _buckets; // _buckets[w % _buckets.size()] holds the elements with weight w.
+        size_t _base = 0; // No element has a smaller weight than this.
+        size_t _max = 0;  // No element has a larger weight than this.
+        size_t _size = 0;
+
+        // Make room for a range of at least n weights, moving the buckets in the current range to their new position.
+        void grow(size_t n) {
+            auto capacity = std::max(min_buckets, _buckets.size());
+            while (capacity < n) {
+                capacity *= 2;
+            }
+            std::vector<std::vector<std::pair<Key,Value>>> buckets(capacity);
+            if (_size > 0) {
+                const auto mask = _buckets.size() - 1;
+                for (auto w = _base; w <= _max; ++w) {
+                    buckets[w & (capacity - 1)] = std::move(_buckets[w & mask]);
+                }
+            }
+            _buckets = std::move(buckets);
+        }
+    };
+
+}
+
+#endif //PDAAAL_PRIORITY_QUEUE_H
@@ -0,0 +1,93 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   q_prime_table.h
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#ifndef PDAAAL_Q_PRIME_TABLE_H
+#define PDAAAL_Q_PRIME_TABLE_H
+
+#include "PDA.h"
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/functional/hash.hpp>
+
+namespace pdaaal::details {
+
+    // The Q' states of post*, i.e. one state q_p'y1 for each (p', y1) in a push rule <p, y> -> <p', y1 y2>,
+    // and the Q' state of each push rule, so applying a push rule finds q_p'y1 with one array load.
+    // Q' states are numbered 0, 1, ... in order of first occurrence in the rules; post* uses state id n_Q + index,
+    // where n_Q is the number of states in the automaton before saturation. The table only depends on the PDA.
+    class q_prime_table {
+    public:
+        static constexpr size_t no_state = std::numeric_limits<size_t>::max();
+
+        q_prime_table() = default;
+        // states is the state vector of a PDA.
+        template <typename States>
+        explicit q_prime_table(const States& states) {
+            update(states);
+        }
+
+        // Recompute the Q' state of each rule after the rules were changed.
+        // Existing Q' states keep their index, and new ones are numbered after them.
+        template <typename States>
+        void update(const States& states) {
+            _offsets.clear();
+            _rule_q_prime.clear();
+            _offsets.reserve(states.size() + 1);
+            for (const auto& state : states) {
+                _offsets.push_back(_rule_q_prime.size());
+                for (const auto& [rule, labels] : state._rules) {
+                    if (rule._operation == PUSH) {
+                        auto res = _index.emplace(std::make_pair(rule._to, rule._op_label), _index.size());
+                        _rule_q_prime.push_back(res.first->second);
+                    } else {
+                        _rule_q_prime.push_back(no_state);
+                    }
+                }
+            }
+            _offsets.push_back(_rule_q_prime.size());
+        }
+
+        // Number of Q' states.
+        [[nodiscard]] size_t size() const { return _index.size(); }
+        // Index of the Q' state of rule number rule_id of state, or no_state if the rule is not a push rule.
+        [[nodiscard]] size_t operator()(size_t state, size_t rule_id) const {
+            assert(_offsets[state] + rule_id < _offsets[state + 1]);
+            return _rule_q_prime[_offsets[state] + rule_id];
+        }
+
+    private:
+        std::unordered_map<std::pair<size_t, uint32_t>, size_t, boost::hash<std::pair<size_t, uint32_t>>> _index; // (p', y1) -> index
+        std::vector<size_t> _offsets; // The rules of state p are at _rule_q_prime[_offsets[p]] to _rule_q_prime[_offsets[p+1]-1].
+        std::vector<size_t> _rule_q_prime;
+    };
+
+}
+
+#endif //PDAAAL_Q_PRIME_TABLE_H
@@ -0,0 +1,125 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   rule_index.h
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#ifndef PDAAAL_RULE_INDEX_H
+#define PDAAAL_RULE_INDEX_H
+
+#include "PDA.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace pdaaal::details {
+
+    // Index from (state, top of stack label) to the ids of the rules of the state whose precondition contains the label.
+    // Used by post*, which for each processed edge (p, y, q) needs the rules <p, y> -> ... .
+    // Rules with a wildcard precondition are stored in one bucket per state, so the size of the index
+    // is linear in the size of the preconditions and does not depend on the number of labels.
+    class rule_index {
+        struct state_index {
+            std::vector<uint32_t> _labels;      // Sorted labels that occur in a (non-wildcard) precondition.
+            std::vector<uint32_t> _offsets;     // The rules for _labels[i] are _rule_ids[_offsets[i]] to _rule_ids[_offsets[i+1]-1].
+            std::vector<uint32_t> _rule_ids;
+            std::vector<uint32_t> _wildcard_rule_ids;
+        };
+    public:
+        rule_index() = default;
+
+        // states is the state vector of a PDA.
+        template <typename States>
+        explicit rule_index(const States& states) {
+            _states.reserve(states.size());
+            std::vector<std::pair<uint32_t,uint32_t>> pairs; // (label, rule id)
+            for (const auto& state : states) {
+                auto& index = _states.emplace_back();
+                pairs.clear();
+                const auto& rules = state._rules;
+                assert(rules.size() < std::numeric_limits<uint32_t>::max());
+                for (uint32_t rule_id = 0; rule_id < rules.size(); ++rule_id) {
+                    const auto& labels = rules[rule_id].second;
+                    if (labels.wildcard()) {
+                        index._wildcard_rule_ids.push_back(rule_id);
+                    } else {
+                        for (auto label : labels.labels()) {
+                            pairs.emplace_back(label, rule_id);
+                        }
+                    }
+                }
+                std::sort(pairs.begin(), pairs.end());
+                index._rule_ids.reserve(pairs.size());
+                for (const auto& [label, rule_id] : pairs) {
+                    if (index._labels.empty() || index._labels.back() != label) {
+                        index._labels.push_back(label);
+                        index._offsets.push_back(static_cast<uint32_t>(index._rule_ids.size()));
+                    }
+                    index._rule_ids.push_back(rule_id);
+                }
+                index._offsets.push_back(static_cast<uint32_t>(index._rule_ids.size()));
+            }
+        }
+
+        // Calls fn(rule_id) for each rule of state whose precondition contains label, in increasing order of rule id.
+        // label must be a concrete label (not wildcard or epsilon).
+        template <typename Fn>
+        void for_each_rule(size_t state, uint32_t label, Fn&& fn) const {
+            assert(state < _states.size());
+            const auto& index = _states[state];
+            const uint32_t* it = nullptr;
+            const uint32_t* end = nullptr;
+            auto lb = std::lower_bound(index._labels.begin(), index._labels.end(), label);
+            if (lb != index._labels.end() && *lb == label) {
+                auto i = lb - index._labels.begin();
+                it = index._rule_ids.data() + index._offsets[i];
+                end = index._rule_ids.data() + index._offsets[i + 1];
+            }
+            auto w_it = index._wildcard_rule_ids.begin();
+            auto w_end = index._wildcard_rule_ids.end();
+            // Merge the two sorted lists, so rules are applied in the same order as when looping over all rules.
+            while (it != end && w_it != w_end) {
+                if (*it < *w_it) {
+                    fn(static_cast<size_t>(*it++));
+                } else {
+                    fn(static_cast<size_t>(*w_it++));
+                }
+            }
+            for (; it != end; ++it) {
+                fn(static_cast<size_t>(*it));
+            }
+            for (; w_it != w_end; ++w_it) {
+                fn(static_cast<size_t>(*w_it));
+            }
+        }
+
+    private:
+        std::vector<state_index> _states;
+    };
+
+}
+
+#endif //PDAAAL_RULE_INDEX_H
@@ -0,0 +1,104 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   saturation_stats.h
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#ifndef PDAAAL_SATURATION_STATS_H
+#define PDAAAL_SATURATION_STATS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+
+namespace pdaaal {
+
+    // Counters describing the work done by a saturation (pre*, post* or shortest-trace post*).
+    struct saturation_stats {
+        size_t edges_inserted = 0;    // New edges added to rel U workset.
+        size_t duplicate_edges = 0;   // Inserts rejected because the edge (or a wildcard edge subsuming it) was already found.
+        size_t steps = 0;             // Edges popped from the workset and processed.
+        size_t peak_workset = 0;      // Largest size of the workset.
+        size_t rules_scanned = 0;     // PDA rules considered for a processed edge.
+        size_t rules_matched = 0;     // Of these, the rules that applied to the edge.
+        size_t q_prime_states = 0;    // Automaton states created for push rules (post* only).
+        size_t traces = 0;            // Traces allocated in the automaton.
+        size_t stale_pops = 0;        // Workset elements skipped because a better weight was already processed (shortest post* only).
+
+        saturation_stats& operator+=(const saturation_stats& other) {
+            edges_inserted += other.edges_inserted;
+            duplicate_edges += other.duplicate_edges;
+            steps += other.steps;
+            peak_workset = std::max(peak_workset, other.peak_workset);
+            rules_scanned += other.rules_scanned;
+            rules_matched += other.rules_matched;
+            q_prime_states += other.q_prime_states;
+            traces += other.traces;
+            stale_pops += other.stale_pops;
+            return *this;
+        }
+        friend std::ostream& operator<<(std::ostream& os, const saturation_stats& stats) {
+            return os << "edges inserted: " << stats.edges_inserted << ", duplicate edges: " << stats.duplicate_edges
+                      << ", steps: " << stats.steps << ", peak workset: " << stats.peak_workset
+                      << ", rules scanned/matched: " << stats.rules_scanned << "/" << stats.rules_matched
+                      << ", Q' states: " << stats.q_prime_states << ", traces: " << stats.traces
+                      << ", stale pops: " << stats.stale_pops;
+        }
+    };
+
+    namespace details {
+        // Used by the saturation classes to fill in saturation_stats. With Enable=false all functions are empty,
+        // so the counting is compiled away.
+        template <bool Enable>
+        struct stats_recorder {
+            void edge_inserted() {}
+            void duplicate_edge() {}
+            void step() {}
+            void workset_size(size_t) {}
+            void rule_scanned() {}
+            void rule_matched() {}
+            void q_prime_state() {}
+            void trace() {}
+            void stale_pop() {}
+            [[nodiscard]] saturation_stats get() const { return saturation_stats{}; }
+        };
+        template <>
+        struct stats_recorder<true> {
+            void edge_inserted() { ++_stats.edges_inserted; }
+            void duplicate_edge() { ++_stats.duplicate_edges; }
+            void step() { ++_stats.steps; }
+            void workset_size(size_t size) { _stats.peak_workset = std::max(_stats.peak_workset, size); }
+            void rule_scanned() { ++_stats.rules_scanned; }
+            void rule_matched() { ++_stats.rules_matched; }
+            void q_prime_state() { ++_stats.q_prime_states; }
+            void trace() { ++_stats.traces; }
+            void stale_pop() { ++_stats.stale_pops; }
+            [[nodiscard]] const saturation_stats& get() const { return _stats; }
+        private:
+            saturation_stats _stats;
+        };
+    }
+
+}
+
+#endif //PDAAAL_SATURATION_STATS_H
@@ -27,6 +27,8 @@
 #ifndef PDAAAL_STD20_H
 #define PDAAAL_STD20_H
 
+#include <cstddef>
+
 // TODO: When C++20 arrives: Delete all this.
 namespace std20{
     template< class T >
@@ -60,4 +62,23 @@ namespace std20 {
     };
 }
 
+namespace std20 {
+    // Read-only view of a contiguous range, until we can use std::span.
+    template<typename T>
+    class span {
+    public:
+        constexpr span() = default;
+        constexpr span(const T* data, std::size_t size) : _data(data), _size(size) {}
+        constexpr const T* begin() const { return _data; }
+        constexpr const T* end() const { return _data + _size; }
+        constexpr const T* data() const { return _data; }
+        constexpr const T& operator[](std::size_t i) const { return _data[i]; }
+        [[nodiscard]] constexpr std::size_t size() const { return _size; }
+        [[nodiscard]] constexpr bool empty() const { return _size == 0; }
+    private:
+        const T* _data = nullptr;
+        std::size_t _size = 0;
+    };
+}
+
 #endif //PDAAAL_STD20_H
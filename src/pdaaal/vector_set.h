@@ -121,6 +121,16 @@ namespace pdaaal::fut {
             }
             return lb;
         }
+        iterator erase(iterator pos) { return elems.erase(pos); }
+        // Returns the number of elements removed (0 or 1).
+        size_t erase(const Key& key) {
+            auto it = find(key);
+            if (it == elems.end()) {
+                return 0;
+            }
+            elems.erase(it);
+            return 1;
+        }
         value_type& operator[](std::size_t index) { return elems[index]; }
         const value_type& operator[](std::size_t index) const { return elems[index]; }
         void resize(size_t count) {
@@ -0,0 +1,136 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   weight_simd.h
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#ifndef PDAAAL_WEIGHT_SIMD_H
+#define PDAAAL_WEIGHT_SIMD_H
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+// SIMD kernel for the lexicographic compare of std::array weights with inner type uint32_t, uint64_t or double.
+// SSE2 is used on x86-64, and AVX2 when compiling with e.g. -mavx2 or -march=native. Define PDAAAL_NO_SIMD to disable.
+#if defined(__SSE2__) && defined(__GNUC__) && !defined(PDAAAL_NO_SIMD)
+#define PDAAAL_SIMD_WEIGHTS
+#include <immintrin.h>
+#endif
+
+namespace pdaaal::details {
+
+#ifdef PDAAAL_SIMD_WEIGHTS
+    // One register of Inner values, with the operations needed by simd_less.
+    // lt/gt return a bit mask with one bit per lane (lowest bit is the first lane), and are only defined when has_compare is true.
+    template <typename Inner> struct simd_lanes;
+
+#ifdef __AVX2__
+    template <> struct simd_lanes<uint32_t> {
+        using reg = __m256i;
+        static constexpr std::size_t size = 8;
+        static constexpr bool has_compare = true;
+        static reg load(const uint32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static reg flip(reg a) { return _mm256_xor_si256(a, _mm256_set1_epi32(INT32_MIN)); } // Unsigned to signed order.
+        static unsigned lt(reg a, reg b) { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(flip(b), flip(a))))); }
+        static unsigned gt(reg a, reg b) { return lt(b, a); }
+    };
+    template <> struct simd_lanes<uint64_t> {
+        using reg = __m256i;
+        static constexpr std::size_t size = 4;
+        static constexpr bool has_compare = true;
+        static reg load(const uint64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static reg flip(reg a) { return _mm256_xor_si256(a, _mm256_set1_epi64x(INT64_MIN)); }
+        static unsigned lt(reg a, reg b) { return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(flip(b), flip(a))))); }
+        static unsigned gt(reg a, reg b) { return lt(b, a); }
+    };
+    template <> struct simd_lanes<double> {
+        using reg = __m256d;
+        static constexpr std::size_t size = 4;
+        static constexpr bool has_compare = true;
+        static reg load(const double* p) { return _mm256_loadu_pd(p); }
+        static unsigned lt(reg a, reg b) { return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LT_OQ))); }
+        static unsigned gt(reg a, reg b) { return lt(b, a); }
+    };
+#else
+    template <> struct simd_lanes<uint32_t> {
+        using reg = __m128i;
+        static constexpr std::size_t size = 4;
+        static constexpr bool has_compare = true;
+        static reg load(const uint32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        static reg flip(reg a) { return _mm_xor_si128(a, _mm_set1_epi32(INT32_MIN)); } // Unsigned to signed order.
+        static unsigned lt(reg a, reg b) { return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(flip(a), flip(b))))); }
+        static unsigned gt(reg a, reg b) { return lt(b, a); }
+    };
+    template <> struct simd_lanes<uint64_t> { // SSE2 has no 64-bit compare, so this falls back to the scalar loop.
+        using reg = __m128i;
+        static constexpr std::size_t size = 2;
+        static constexpr bool has_compare = false;
+        static reg load(const uint64_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    };
+    template <> struct simd_lanes<double> {
+        using reg = __m128d;
+        static constexpr std::size_t size = 2;
+        static constexpr bool has_compare = true;
+        static reg load(const double* p) { return _mm_loadu_pd(p); }
+        static unsigned lt(reg a, reg b) { return static_cast<unsigned>(_mm_movemask_pd(_mm_cmplt_pd(a, b))); }
+        static unsigned gt(reg a, reg b) { return lt(b, a); }
+    };
+#endif
+
+    // Whether simd_less should be used for std::array<Inner,N>. It needs a lane compare and at least one full register,
+    // otherwise it is just the scalar loop (measured with benchmark/weight_benchmark.cpp).
+    template <typename Inner, std::size_t N, typename = void> struct use_simd_less : std::false_type {};
+    template <typename Inner, std::size_t N> struct use_simd_less<Inner, N, std::void_t<decltype(simd_lanes<Inner>::has_compare)>>
+            : std::bool_constant<simd_lanes<Inner>::has_compare && N >= simd_lanes<Inner>::size> {};
+    template <typename Inner, std::size_t N>
+    inline constexpr bool has_simd_kernel = use_simd_less<Inner, N>::value;
+
+    // Lexicographic lhs < rhs with the same result as std::lexicographical_compare (also for NaN, which is neither less nor greater).
+    template <typename Inner, std::size_t N>
+    inline bool simd_less(const Inner* lhs, const Inner* rhs) {
+        std::size_t i = 0;
+        using lanes = simd_lanes<Inner>;
+        for (; i + lanes::size <= N; i += lanes::size) {
+            auto a = lanes::load(lhs + i);
+            auto b = lanes::load(rhs + i);
+            auto lt = lanes::lt(a, b);
+            auto decided = lt | lanes::gt(a, b);
+            if (decided != 0) {
+                return (lt >> __builtin_ctz(decided)) & 1u;
+            }
+        }
+        for (; i < N; ++i) {
+            if (lhs[i] < rhs[i]) return true;
+            if (rhs[i] < lhs[i]) return false;
+        }
+        return false;
+    }
+#else
+    template <typename Inner, std::size_t N>
+    inline constexpr bool has_simd_kernel = false;
+#endif
+
+}
+
+#endif //PDAAAL_WEIGHT_SIMD_H
@@ -0,0 +1,206 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   workset.h
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#ifndef PDAAAL_WORKSET_H
+#define PDAAAL_WORKSET_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace pdaaal {
+
+    // Workset policies for the unweighted pre* and post* saturations, which decide the order edges are processed in.
+    // The saturated automaton is the same for all orders, but with early termination the order decides how soon a witness is found.
+    // A workset holds edges (Elem has _from, _label and _to), and has push(elem), pop(), empty() and size().
+
+    // Last in, first out (depth-first). The default for pre*.
+    template <typename Elem>
+    class lifo_workset {
+    public:
+        void push(const Elem& elem) { _elems.push_back(elem); }
+        Elem pop() {
+            assert(!_elems.empty());
+            auto elem = _elems.back();
+            _elems.pop_back();
+            return elem;
+        }
+        [[nodiscard]] bool empty() const { return _elems.empty(); }
+        [[nodiscard]] size_t size() const { return _elems.size(); }
+    private:
+        std::vector<Elem> _elems;
+    };
+
+    // First in, first out (breadth-first). The default for post*.
+    template <typename Elem>
+    class fifo_workset {
+    public:
+        void push(const Elem& elem) { _elems.push_back(elem); }
+        Elem pop() {
+            assert(!_elems.empty());
+            auto elem = _elems.front();
+            _elems.pop_front();
+            return elem;
+        }
+        [[nodiscard]] bool empty() const { return _elems.empty(); }
+        [[nodiscard]] size_t size() const { return _elems.size(); }
+    private:
+        std::deque<Elem> _elems;
+    };
+
+    // First in, first out in a ring buffer of fixed-size chunks. A chunk is reused when it has been emptied,
+    // so after the workset has reached its largest size, push and pop do not allocate.
+    template <typename Elem>
+    class ring_workset {
+        static constexpr size_t ChunkBits = 10;
+        static constexpr size_t chunk_size = size_t(1) << ChunkBits;
+        static constexpr size_t chunk_mask = chunk_size - 1;
+    public:
+        void push(const Elem& elem) {
+            if (_size == _chunks.size() * chunk_size) {
+                grow();
+            }
+            auto i = (_head + _size) & (_chunks.size() * chunk_size - 1);
+            _chunks[i >> ChunkBits][i & chunk_mask] = elem;
+            ++_size;
+        }
+        Elem pop() {
+            assert(_size > 0);
+            auto elem = _chunks[_head >> ChunkBits][_head & chunk_mask];
+            _head = (_head + 1) & (_chunks.size() * chunk_size - 1);
+            --_size;
+            return elem;
+        }
+        [[nodiscard]] bool empty() const { return _size == 0; }
+        [[nodiscard]] size_t size() const { return _size; }
+    private:
+        std::vector<std::vector<Elem>> _chunks; // The number of chunks is a power of two, so positions wrap around with a mask.
+        size_t _head = 0;
+        size_t _size = 0;
+
+        // Double the number of chunks, and rotate them so the elements start in the first chunk. Only the chunk pointers are moved.
+        void grow() {
+            auto n_chunks = _chunks.size();
+            std::vector<std::vector<Elem>> chunks;
+            chunks.reserve(std::max<size_t>(1, 2 * n_chunks));
+            auto first = _head >> ChunkBits;
+            for (size_t i = 0; i < n_chunks; ++i) {
+                chunks.emplace_back(std::move(_chunks[(first + i) % n_chunks]));
+            }
+            while (chunks.size() < std::max<size_t>(1, 2 * n_chunks)) {
+                chunks.emplace_back(chunk_size);
+            }
+            _chunks = std::move(chunks);
+            _head &= chunk_mask;
+            if (n_chunks > 0 && _head != 0) {
+                // The workset is full, so the elements before _head in the first chunk are the last ones. Move them to the first new chunk.
+                for (size_t i = 0; i < _head; ++i) {
+                    _chunks[n_chunks][i] = _chunks[0][i];
+                }
+            }
+        }
+    };
+
+    // Pops an edge with the smallest value of Heuristic first, e.g. an estimate of the distance from the edge to a goal.
+    // Heuristic is called as heuristic(from, label, to) and returns a size_t.
+    template <typename Elem, typename Heuristic>
+    class heuristic_workset {
+        using entry_t = std::pair<size_t,Elem>;
+        struct entry_comp {
+            bool operator()(const entry_t& lhs, const entry_t& rhs) const {
+                return lhs.first > rhs.first; // Used in a max-heap, so swap the order to make it a min-heap.
+            }
+        };
+    public:
+        explicit heuristic_workset(Heuristic heuristic = Heuristic()) : _heuristic(std::move(heuristic)) {};
+
+        void push(const Elem& elem) {
+            _heap.emplace(_heuristic(elem._from, elem._label, elem._to), elem);
+        }
+        Elem pop() {
+            assert(!_heap.empty());
+            auto elem = _heap.top().second;
+            _heap.pop();
+            return elem;
+        }
+        [[nodiscard]] bool empty() const { return _heap.empty(); }
+        [[nodiscard]] size_t size() const { return _heap.size(); }
+    private:
+        Heuristic _heuristic;
+        std::priority_queue<entry_t, std::vector<entry_t>, entry_comp> _heap;
+    };
+    // heuristic_workset with a given Heuristic as a template with one parameter, as used by the saturations.
+    template <typename Heuristic>
+    struct heuristic_order {
+        template <typename Elem>
+        using workset = heuristic_workset<Elem, Heuristic>;
+    };
+
+    // Heuristic for goal-directed post*: The number of rules needed (ignoring the stack) to go from the control state of an edge
+    // to one of the goal states. Edges from states that are not PDA states (e.g. Q' states in post*) get 0.
+    // States that cannot reach a goal state get the largest value, so their edges are processed last.
+    class goal_distance {
+    public:
+        goal_distance() = default;
+        // The distance to a goal state along the rules of pda, using the _pre_states of each state.
+        template <typename PDA>
+        goal_distance(const PDA& pda, const std::vector<size_t>& goal_states)
+        : _distance(pda.states().size(), std::numeric_limits<size_t>::max()) {
+            std::queue<size_t> waiting;
+            for (auto state : goal_states) {
+                if (_distance[state] != 0) {
+                    _distance[state] = 0;
+                    waiting.push(state);
+                }
+            }
+            while (!waiting.empty()) { // Breadth-first search backwards along the rules.
+                auto state = waiting.front();
+                waiting.pop();
+                for (auto pre_state : pda.states()[state]._pre_states) {
+                    if (_distance[pre_state] == std::numeric_limits<size_t>::max()) {
+                        _distance[pre_state] = _distance[state] + 1;
+                        waiting.push(pre_state);
+                    }
+                }
+            }
+        }
+
+        size_t operator()(size_t from, uint32_t, size_t) const {
+            return from < _distance.size() ? _distance[from] : 0;
+        }
+    private:
+        std::vector<size_t> _distance;
+    };
+
+}
+
+#endif //PDAAAL_WORKSET_H
@@ -0,0 +1,165 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   BatchQuery_test.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#define BOOST_TEST_MODULE BatchQuery
+
+#include <pdaaal/BatchQuery.h>
+#include <pdaaal/Solver.h>
+#include <boost/test/unit_test.hpp>
+#include <random>
+
+using namespace pdaaal;
+
+TypedPDA<char> random_pda(size_t n_states, size_t n_rules, unsigned int seed) {
+    std::unordered_set<char> labels{'A', 'B', 'C'};
+    std::vector<char> label_list{'A', 'B', 'C'};
+    std::vector<op_t> ops{PUSH, POP, SWAP, NOOP};
+    TypedPDA<char> pda(labels);
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<size_t> state_dist(0, n_states - 1);
+    std::uniform_int_distribution<size_t> label_dist(0, label_list.size() - 1);
+    std::uniform_int_distribution<size_t> op_dist(0, ops.size() - 1);
+    for (size_t i = 0; i < n_rules; ++i) {
+        auto from = state_dist(gen);
+        auto to = state_dist(gen);
+        auto op = ops[op_dist(gen)];
+        auto op_label = label_list[label_dist(gen)];
+        if (label_dist(gen) == 0) {
+            pda.add_rule(from, to, op, op_label, true, std::vector<char>()); // Wildcard
+        } else {
+            pda.add_rule(from, to, op, op_label, label_list[label_dist(gen)]);
+        }
+    }
+    pda.add_rule(n_states - 1, n_states - 1, NOOP, 'A', 'A'); // Make sure all states exist.
+    return pda;
+}
+
+std::vector<std::vector<char>> all_stacks(size_t max_length) {
+    std::vector<std::vector<char>> result{{}};
+    for (size_t i = 0; i < result.size(); ++i) {
+        if (result[i].size() == max_length) continue;
+        for (char label : {'A', 'B', 'C'}) {
+            auto stack = result[i];
+            stack.push_back(label);
+            result.push_back(std::move(stack));
+        }
+    }
+    return result;
+}
+
+bool nfa_accepts(const NFA<char>& nfa, const std::vector<char>& stack) {
+    std::vector<const NFA<char>::state_t*> states(nfa.initial().begin(), nfa.initial().end());
+    for (char label : stack) {
+        states = NFA<char>::successor(states, label);
+    }
+    return std::any_of(states.begin(), states.end(), [](const auto* s){ return s->_accepting; });
+}
+
+BOOST_AUTO_TEST_CASE(BatchQuerySameAsAccepts)
+{
+    auto stacks = all_stacks(5);
+    for (unsigned int seed = 0; seed < 5; ++seed) {
+        auto pda = random_pda(10, 30, seed);
+        PAutomaton automaton(pda, 0, pda.encode_pre(std::vector<char>{'A', 'B'}));
+        Solver::pre_star(automaton);
+
+        BatchQuery queries(automaton);
+        std::vector<bool> expected;
+        for (size_t state = 0; state < 10; ++state) {
+            for (const auto& stack : stacks) {
+                auto encoded = pda.encode_pre(stack);
+                BOOST_CHECK_EQUAL(queries.add(state, encoded), expected.size());
+                expected.push_back(automaton.accepts(state, encoded));
+            }
+        }
+        auto id = queries.add(3, pda.encode_pre(std::vector<char>{'A', 'B'})); // Duplicate query
+        expected.push_back(automaton.accepts(3, pda.encode_pre(std::vector<char>{'A', 'B'})));
+        const auto& result = queries.run();
+        BOOST_CHECK_EQUAL(result.size(), expected.size());
+        BOOST_CHECK(result == expected);
+        BOOST_CHECK_EQUAL(result[id], result[3 * stacks.size() + 5]); // stacks[5] is AB
+        BOOST_CHECK(std::any_of(result.begin(), result.end(), [](bool b){ return b; }));
+        BOOST_CHECK(queries.queries_per_second() > 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BatchQueryNFA)
+{
+    auto stacks = all_stacks(4);
+    for (unsigned int seed = 0; seed < 5; ++seed) {
+        auto pda = random_pda(10, 30, seed);
+        PAutomaton automaton(pda, 0, pda.encode_pre(std::vector<char>{'A', 'B'}));
+        Solver::pre_star(automaton);
+
+        // Finite languages, so we can compare with all stacks up to length 4.
+        std::vector<NFA<char>> nfas;
+        { // A [^A] C?
+            NFA<char> nfa(std::unordered_set<char>{'A'});
+            nfa.concat(NFA<char>(std::unordered_set<char>{'A'}, true));
+            NFA<char> c(std::unordered_set<char>{'C'});
+            c.question_extend();
+            nfa.concat(std::move(c));
+            nfas.push_back(std::move(nfa));
+        }
+        { // (A B) | (. . . B)
+            NFA<char> nfa(std::unordered_set<char>{'A'});
+            nfa.concat(NFA<char>(std::unordered_set<char>{'B'}));
+            NFA<char> other(std::unordered_set<char>{}, true);
+            other.concat(NFA<char>(std::unordered_set<char>{}, true));
+            other.concat(NFA<char>(std::unordered_set<char>{}, true));
+            other.concat(NFA<char>(std::unordered_set<char>{'B'}));
+            nfa.or_extend(std::move(other));
+            nfas.push_back(std::move(nfa));
+        }
+        { // C?
+            NFA<char> nfa(std::unordered_set<char>{'C'});
+            nfa.question_extend();
+            nfas.push_back(std::move(nfa));
+        }
+        for (auto& nfa : nfas) {
+            nfa.compile();
+        }
+        std::vector<std::vector<size_t>> state_sets{{0}, {1, 2, 3}, {4, 5, 6, 7, 8, 9}, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}};
+
+        BatchQuery queries(automaton);
+        std::vector<bool> expected;
+        for (const auto& nfa : nfas) {
+            for (const auto& states : state_sets) {
+                queries.add(pda, states, nfa);
+                bool accepted = false;
+                for (const auto& stack : stacks) {
+                    if (!nfa_accepts(nfa, stack)) continue;
+                    for (auto state : states) {
+                        accepted = accepted || automaton.accepts(state, pda.encode_pre(stack));
+                    }
+                }
+                expected.push_back(accepted);
+            }
+        }
+        BOOST_CHECK(queries.run() == expected);
+        BOOST_CHECK(queries.run() == expected); // Again, with the search buffers from the first run.
+    }
+}
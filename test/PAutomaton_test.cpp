@@ -46,10 +46,10 @@ BOOST_AUTO_TEST_CASE(Dijkstra_Test_1)
     auto id3 = automaton.add_state(false, false);
     auto id4 = automaton.add_state(false, true);
 
-    automaton.add_edge(0, id1, 0, std::make_pair(nullptr, 1));
-    automaton.add_edge(0, id2, 0, std::make_pair(nullptr, 2));
-    automaton.add_edge(id1, id3, 0, std::make_pair(nullptr, 2));
-    automaton.add_edge(id3, id4, 0, std::make_pair(nullptr, 2));
+    automaton.add_edge(0, id1, 0, std::make_pair(no_trace, 1));
+    automaton.add_edge(0, id2, 0, std::make_pair(no_trace, 2));
+    automaton.add_edge(id1, id3, 0, std::make_pair(no_trace, 2));
+    automaton.add_edge(id3, id4, 0, std::make_pair(no_trace, 2));
 
     std::vector<char> test_stack{'A', 'A', 'A'};
     std::vector<size_t> correct_path{0,id1,id3,id4};
@@ -57,7 +57,7 @@ BOOST_AUTO_TEST_CASE(Dijkstra_Test_1)
     BOOST_CHECK_EQUAL(w, 5);
     BOOST_CHECK_EQUAL_COLLECTIONS(path.begin(), path.end(), correct_path.begin(), correct_path.end());
 
-    automaton.add_edge(id2, id3, 0, std::make_pair(nullptr, 2));
+    automaton.add_edge(id2, id3, 0, std::make_pair(no_trace, 2));
 
     // A bug in the implementation of Dijkstra in PAutomaton caused the following to fail. It is now fixed.
     auto [path2, w2] = automaton.template accept_path<Trace_Type::Shortest>(0, pda.encode_pre(test_stack));
@@ -65,6 +65,35 @@ BOOST_AUTO_TEST_CASE(Dijkstra_Test_1)
     BOOST_CHECK_EQUAL_COLLECTIONS(path2.begin(), path2.end(), correct_path.begin(), correct_path.end());
 }
 
+BOOST_AUTO_TEST_CASE(InternedTraces)
+{
+    std::unordered_set<char> labels{'A', 'B'};
+    TypedPDA<char> pda(labels);
+    pda.add_rule(0, 0, NOOP, 'A', 'A');
+    PAutomaton automaton(pda, 0, pda.encode_pre(std::vector<char>{'A'}));
+
+    auto id1 = automaton.new_pre_trace(3);
+    auto id2 = automaton.new_post_trace(1, 3, 0);
+    BOOST_CHECK_NE(id1, no_trace);
+    BOOST_CHECK_NE(id1, id2);
+    BOOST_CHECK_EQUAL(automaton.new_pre_trace(3), id1); // Equal traces share one record.
+    BOOST_CHECK_EQUAL(automaton.new_post_trace(1, 3, 0), id2);
+    BOOST_CHECK_EQUAL(automaton.number_of_traces(), 2);
+
+    const trace_t* trace = automaton.get_trace(id2);
+    for (size_t i = 0; i < 10000; ++i) { // Spans several chunks and rehashes.
+        automaton.new_post_trace(i);
+    }
+    BOOST_CHECK_EQUAL(automaton.number_of_traces(), 10002);
+    BOOST_CHECK_EQUAL(automaton.get_trace(id2), trace); // References stay valid.
+    BOOST_CHECK_EQUAL(automaton.new_post_trace(9999), 10002);
+    BOOST_CHECK(automaton.get_trace(no_trace) == nullptr);
+
+    PAutomaton copy(automaton);
+    BOOST_CHECK_EQUAL(copy.get_trace(id2)->_state, 1);
+    BOOST_CHECK(copy.get_trace(id1)->is_pre_trace());
+}
+
 BOOST_AUTO_TEST_CASE(UnweightedPreStar)
 {
     // This is pretty much the rules from the example in Figure 3.1 (Schwoon-php02)
@@ -458,3 +487,80 @@ BOOST_AUTO_TEST_CASE(WeightedShortestPerformance)
     BOOST_TEST_MESSAGE( "ShortestTrace: " << std::to_string(duration_short_post) << " PostStar: " << std::to_string(duration_post));
 }
 
+
+template <typename W>
+std::map<std::tuple<size_t,uint32_t,size_t>,W> edge_weights(const PAutomaton<W>& automaton) {
+    std::map<std::tuple<size_t,uint32_t,size_t>,W> result;
+    for (const auto& from : automaton.states()) {
+        for (const auto& [to,labels] : from->_edges) {
+            for (const auto& [label,trace] : labels) {
+                result.emplace(std::make_tuple(from->_id, label, to), trace.second);
+            }
+        }
+    }
+    return result;
+}
+
+BOOST_AUTO_TEST_CASE(WeightedPostStarQueuePolicies)
+{
+    TypedPDA<int, int> pda = create_syntactic_network_deep(20);
+    std::vector<int> init_stack{0};
+
+    PAutomaton automaton(pda, 0, pda.encode_pre(init_stack));
+    PAutomaton addressable_automaton(pda, 0, pda.encode_pre(init_stack));
+    PAutomaton bucket_automaton(pda, 0, pda.encode_pre(init_stack));
+    Solver::post_star<Trace_Type::Shortest>(automaton);
+    Solver::post_star<Trace_Type::Shortest,int,std::less<int>,add<int>,false,addressable_heap_queue>(addressable_automaton);
+    Solver::post_star<Trace_Type::Shortest,int,std::less<int>,add<int>,false,bucket_queue>(bucket_automaton);
+
+    auto weights = edge_weights(automaton);
+    BOOST_CHECK(weights == edge_weights(addressable_automaton));
+    BOOST_CHECK(weights == edge_weights(bucket_automaton));
+
+    std::vector<int> test_stack{0, 0, 0};
+    auto [path, w] = automaton.accept_path<Trace_Type::Shortest>(0, pda.encode_pre(test_stack));
+    auto [bucket_path, bucket_w] = bucket_automaton.accept_path<Trace_Type::Shortest>(0, pda.encode_pre(test_stack));
+    BOOST_CHECK_EQUAL(w, bucket_w);
+}
+
+BOOST_AUTO_TEST_CASE(WeightedPostStarAddressableHeapLexicographic)
+{
+    using W = std::array<int,2>;
+    std::unordered_set<char> labels{'A', 'B'};
+    TypedPDA<char, W> pda(labels);
+    pda.add_rule(0, 1, SWAP, 'B', 'A', W{1, 0});
+    pda.add_rule(0, 2, PUSH, 'B', 'A', W{0, 5}); // Detour that is longer in the second component, but shorter lexicographically.
+    pda.add_rule(2, 4, POP , 'B', 'B', W{0, 5});
+    pda.add_rule(4, 1, SWAP, 'B', 'A', W{0, 5});
+    pda.add_rule(1, 3, NOOP, 'B', 'B', W{0, 1});
+
+    std::vector<char> init_stack{'A'};
+    PAutomaton automaton(pda, 0, pda.encode_pre(init_stack));
+    PAutomaton addressable_automaton(pda, 0, pda.encode_pre(init_stack));
+    Solver::post_star<Trace_Type::Shortest>(automaton);
+    Solver::post_star<Trace_Type::Shortest,W,std::less<W>,add<W>,false,addressable_heap_queue>(addressable_automaton);
+
+    BOOST_CHECK(edge_weights(automaton) == edge_weights(addressable_automaton));
+    std::vector<char> test_stack{'B'};
+    auto [path, w] = addressable_automaton.accept_path<Trace_Type::Shortest>(3, pda.encode_pre(test_stack));
+    BOOST_CHECK(w == (W{0, 16}));
+}
+
+BOOST_AUTO_TEST_CASE(WeightedPostStarWeightLess)
+{
+    using W = std::array<uint32_t,4>;
+    std::unordered_set<char> labels{'A', 'B'};
+    TypedPDA<char, W, weight_less<W>> pda(labels);
+    pda.add_rule(0, 1, SWAP, 'B', 'A', W{0, 1, 0, 0});
+    pda.add_rule(0, 2, PUSH, 'B', 'A', W{0, 0, 5, 0});
+    pda.add_rule(2, 4, POP , 'B', 'B', W{0, 0, 5, 0});
+    pda.add_rule(4, 1, SWAP, 'B', 'A', W{0, 0, 5, 0});
+
+    std::vector<char> init_stack{'A'};
+    PAutomaton automaton(pda, 0, pda.encode_pre(init_stack));
+    Solver::post_star<Trace_Type::Shortest>(automaton);
+
+    std::vector<char> test_stack{'B'};
+    auto [path, w] = automaton.accept_path<Trace_Type::Shortest>(1, pda.encode_pre(test_stack));
+    BOOST_CHECK(w == (W{0, 0, 15, 0}));
+}
@@ -28,6 +28,8 @@
 
 #include <boost/test/unit_test.hpp>
 #include <pdaaal/Solver.h>
+#include <pdaaal/BoundedHeightPDA.h>
+#include <random>
 
 using namespace pdaaal;
 
@@ -148,4 +150,1136 @@ BOOST_AUTO_TEST_CASE(EarlyTerminationPreStar)
 
     auto trace = Solver::get_trace(pda, automaton, 0, test_stack_reachable);
     BOOST_CHECK_EQUAL(trace.size(), 12);
-}
\ No newline at end of file
+}
+// Edges of the automaton, where wildcard edges are expanded to concrete labels.
+template <typename W, typename C, typename A>
+std::set<std::tuple<size_t,uint32_t,size_t>> get_edges(const PAutomaton<W,C,A>& automaton) {
+    std::set<std::tuple<size_t,uint32_t,size_t>> result;
+    for (const auto& from : automaton.states()) {
+        for (const auto& [to,labels] : from->_edges) {
+            for (const auto& [label,_] : labels) {
+                if (label == PAutomaton<W,C,A>::wildcard) {
+                    for (uint32_t l = 0; l < automaton.number_of_labels(); ++l) {
+                        result.emplace(from->_id, l, to);
+                    }
+                } else {
+                    result.emplace(from->_id, label, to);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+// Adds rule number first_rule to last_rule-1 of a random sequence of rules.
+void add_random_rules(TypedPDA<char>& pda, size_t n_states, size_t n_rules, unsigned int seed,
+                      size_t first_rule = 0, size_t last_rule = std::numeric_limits<size_t>::max()) {
+    std::vector<char> label_list{'A', 'B', 'C'};
+    std::vector<op_t> ops{PUSH, POP, SWAP, NOOP};
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<size_t> state_dist(0, n_states - 1);
+    std::uniform_int_distribution<size_t> label_dist(0, label_list.size() - 1);
+    std::uniform_int_distribution<size_t> op_dist(0, ops.size() - 1);
+    for (size_t i = 0; i < n_rules; ++i) {
+        auto from = state_dist(gen);
+        auto to = state_dist(gen);
+        auto op = ops[op_dist(gen)];
+        auto op_label = label_list[label_dist(gen)];
+        bool wildcard = label_dist(gen) == 0;
+        auto pre = label_list[label_dist(gen)];
+        if (i < first_rule || i >= last_rule) continue;
+        if (wildcard) {
+            pda.add_rule(from, to, op, op_label, true, std::vector<char>()); // Wildcard
+        } else {
+            pda.add_rule(from, to, op, op_label, pre);
+        }
+    }
+}
+
+TypedPDA<char> random_pda(size_t n_states, size_t n_rules, unsigned int seed, size_t last_rule = std::numeric_limits<size_t>::max()) {
+    std::unordered_set<char> labels{'A', 'B', 'C'};
+    TypedPDA<char> pda(labels);
+    add_random_rules(pda, n_states, n_rules, seed, 0, last_rule);
+    pda.add_rule(n_states - 1, n_states - 1, NOOP, 'A', 'A'); // Make sure all states exist.
+    return pda;
+}
+
+// Check that each step of the trace is an application of a rule in the PDA.
+template <typename W>
+bool valid_trace(const TypedPDA<char,W>& pda, const std::vector<typename TypedPDA<char,W>::tracestate_t>& trace) {
+    for (size_t i = 1; i < trace.size(); ++i) {
+        auto from_stack = pda.encode_pre(trace[i-1]._stack);
+        auto to_stack = pda.encode_pre(trace[i]._stack);
+        if (from_stack.empty()) return false;
+        bool found = false;
+        for (const auto& [rule, labels] : pda.states()[trace[i-1]._pdastate]._rules) {
+            if (rule._to != trace[i]._pdastate || !labels.contains(from_stack[0])) continue;
+            std::vector<uint32_t> expected(from_stack.begin() + 1, from_stack.end());
+            switch (rule._operation) {
+                case POP: break;
+                case SWAP: expected.insert(expected.begin(), rule._op_label); break;
+                case NOOP: expected.insert(expected.begin(), from_stack[0]); break;
+                case PUSH: expected.insert(expected.begin(), {rule._op_label, from_stack[0]}); break;
+            }
+            if (expected == to_stack) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) return false;
+    }
+    return true;
+}
+
+TypedPDA<int> wildcard_pda() {
+    std::unordered_set<int> labels;
+    for (int i = 0; i < 1000; ++i) {
+        labels.insert(i);
+    }
+    TypedPDA<int> pda(labels);
+    pda.add_rule(0, 1, SWAP, 5, true, std::vector<int>());
+    pda.add_rule(0, 3, NOOP, 0, true, std::vector<int>());
+    pda.add_rule(0, 4, PUSH, 7, true, std::vector<int>());
+    pda.add_rule(1, 2, POP , 0, true, std::vector<int>());
+    return pda;
+}
+
+BOOST_AUTO_TEST_CASE(WildcardEdgesPreStar)
+{
+    auto pda = wildcard_pda();
+    PAutomaton automaton(pda, 2, pda.encode_pre(std::vector<int>{9}));
+    Solver::pre_star(automaton);
+
+    // Wildcard rules give a single wildcard edge instead of an edge per label.
+    BOOST_CHECK_EQUAL(automaton.states()[1]->_edges.size(), 1);
+    BOOST_CHECK_EQUAL(automaton.states()[0]->_edges.size(), 1);
+    for (const auto& [to,labels] : automaton.states()[0]->_edges) {
+        BOOST_CHECK_EQUAL(to, 2);
+        BOOST_CHECK_EQUAL(labels.size(), 1);
+        BOOST_CHECK(labels.contains(PAutomaton<>::wildcard));
+    }
+    BOOST_CHECK(automaton.accepts(0, pda.encode_pre(std::vector<int>{123, 9})));
+    BOOST_CHECK(!automaton.accepts(0, pda.encode_pre(std::vector<int>{123, 5})));
+
+    auto trace = Solver::get_trace(pda, automaton, 0, std::vector<int>{123, 9});
+    BOOST_REQUIRE_EQUAL(trace.size(), 3);
+    BOOST_CHECK_EQUAL(trace[1]._pdastate, 1);
+    BOOST_REQUIRE_EQUAL(trace[1]._stack.size(), 2);
+    BOOST_CHECK_EQUAL(trace[1]._stack[0], 5);
+    BOOST_CHECK_EQUAL(trace[2]._pdastate, 2);
+    BOOST_CHECK_EQUAL(trace[2]._stack.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(WildcardEdgesPostStar)
+{
+    auto pda = wildcard_pda();
+    NFA<int> nfa(std::unordered_set<int>{}, true); // Any single label
+    nfa.compile();
+    PAutomaton automaton(pda, nfa, std::vector<size_t>{0});
+    Solver::post_star(automaton);
+
+    for (const auto& from : automaton.states()) {
+        for (const auto& [to,labels] : from->_edges) {
+            BOOST_CHECK_EQUAL(labels.size(), 1);
+        }
+    }
+    BOOST_CHECK(automaton.accepts(3, pda.encode_pre(std::vector<int>{123})));
+    BOOST_CHECK(automaton.accepts(4, pda.encode_pre(std::vector<int>{7, 123})));
+    BOOST_CHECK(automaton.accepts(1, pda.encode_pre(std::vector<int>{5})));
+    BOOST_CHECK(!automaton.accepts(1, pda.encode_pre(std::vector<int>{6})));
+
+    auto trace = Solver::get_trace(pda, automaton, 4, std::vector<int>{7, 123});
+    BOOST_REQUIRE_EQUAL(trace.size(), 2);
+    BOOST_CHECK_EQUAL(trace[0]._pdastate, 0);
+    BOOST_REQUIRE_EQUAL(trace[0]._stack.size(), 1);
+    BOOST_CHECK_EQUAL(trace[0]._stack[0], 123);
+
+    auto trace_swap = Solver::get_trace(pda, automaton, 1, std::vector<int>{5});
+    BOOST_REQUIRE_EQUAL(trace_swap.size(), 2);
+    BOOST_CHECK_EQUAL(trace_swap[0]._pdastate, 0);
+    BOOST_CHECK_EQUAL(trace_swap[0]._stack.size(), 1);
+}
+
+// Every stack is accepted by the initial and final automata, so the product has wildcard edges, but the first rule
+// can not be applied to label 0. The traces must use a label that the rules accept.
+BOOST_AUTO_TEST_CASE(WildcardEdgesTraceLabel)
+{
+    auto check = [](auto&& accepts, auto&& get_trace) {
+        TypedPDA<char> pda(std::unordered_set<char>{'A', 'B'});
+        auto zero_label = pda.get_symbol(0);
+        pda.add_rule(0, 1, SWAP, zero_label, true, std::vector<char>{zero_label}); // Any label except label 0.
+        pda.add_rule(1, 2, POP, zero_label, false, std::vector<char>{zero_label});
+        NFA<char> initial(std::unordered_set<char>{}, true);
+        initial.concat(NFA<char>(std::unordered_set<char>{}, true));
+        NFA<char> final(std::unordered_set<char>{}, true);
+        initial.compile();
+        final.compile();
+        SolverInstance<char,void,std::less<void>,add<void>> instance(std::move(pda), initial, {0}, final, {2});
+        BOOST_REQUIRE(accepts(instance));
+        auto trace = get_trace(instance);
+        BOOST_REQUIRE_EQUAL(trace.size(), 3);
+        BOOST_REQUIRE_EQUAL(trace.front()._stack.size(), 2);
+        BOOST_CHECK_NE(trace.front()._stack[0], zero_label);
+        BOOST_CHECK(valid_trace(instance.pda(), trace));
+    };
+    auto get_trace = [](const auto& instance){ return Solver::get_trace(instance); };
+    check([](auto& instance){ return Solver::pre_star_accepts(instance); }, get_trace);
+    check([](auto& instance){ return Solver::post_star_accepts(instance); }, get_trace);
+    check([](auto& instance){ return Solver::pre_star_accepts_fused(instance); }, get_trace);
+    check([](auto& instance){ return Solver::post_star_accepts_fused(instance); }, get_trace);
+    check([](auto& instance){ return Solver::dual_search_accepts(instance); },
+          [](const auto& instance){ return Solver::get_trace_dual_search(instance); });
+}
+
+BOOST_AUTO_TEST_CASE(ParallelPreStarSameEdges)
+{
+    for (unsigned int seed = 0; seed < 10; ++seed) {
+        auto pda = random_pda(12, 40, seed);
+        std::vector<char> init_stack{'A', 'B'};
+        PAutomaton automaton(pda, 0, pda.encode_pre(init_stack));
+        PAutomaton parallel_automaton(pda, 0, pda.encode_pre(init_stack));
+
+        Solver::pre_star(automaton);
+        Solver::pre_star_parallel(parallel_automaton, 4);
+
+        auto edges = get_edges(automaton);
+        auto parallel_edges = get_edges(parallel_automaton);
+        BOOST_CHECK_EQUAL(edges.size(), parallel_edges.size());
+        BOOST_CHECK(edges == parallel_edges);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ParallelPostStarSameEdges)
+{
+    for (unsigned int seed = 0; seed < 10; ++seed) {
+        auto pda = random_pda(12, 40, seed);
+        std::vector<char> init_stack{'A', 'B'};
+        PAutomaton automaton(pda, 0, pda.encode_pre(init_stack));
+        PAutomaton parallel_automaton(pda, 0, pda.encode_pre(init_stack));
+
+        Solver::post_star(automaton);
+        Solver::post_star_parallel(parallel_automaton, 4);
+
+        BOOST_CHECK_EQUAL(automaton.states().size(), parallel_automaton.states().size());
+        auto edges = get_edges(automaton);
+        auto parallel_edges = get_edges(parallel_automaton);
+        BOOST_CHECK_EQUAL(edges.size(), parallel_edges.size());
+        BOOST_CHECK(edges == parallel_edges);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(NoTracePreStarSameEdges)
+{
+    for (unsigned int seed = 0; seed < 10; ++seed) {
+        auto pda = random_pda(12, 40, seed);
+        std::vector<char> init_stack{'A', 'B'};
+        PAutomaton automaton(pda, 0, pda.encode_pre(init_stack));
+        PAutomaton no_trace_automaton(pda, 0, pda.encode_pre(init_stack));
+        PAutomaton parallel_automaton(pda, 0, pda.encode_pre(init_stack));
+
+        Solver::pre_star(automaton);
+        Solver::pre_star<Trace_Type::None,void,std::less<void>,add<void>,false>(no_trace_automaton);
+        Solver::pre_star_parallel<Trace_Type::None,void,std::less<void>,add<void>,false>(parallel_automaton, 4);
+
+        auto edges = get_edges(automaton);
+        BOOST_CHECK(edges == get_edges(no_trace_automaton));
+        BOOST_CHECK(edges == get_edges(parallel_automaton));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(NoTracePostStarSameEdges)
+{
+    for (unsigned int seed = 0; seed < 10; ++seed) {
+        auto pda = random_pda(12, 40, seed);
+        std::vector<char> init_stack{'A', 'B'};
+        PAutomaton automaton(pda, 0, pda.encode_pre(init_stack));
+        PAutomaton no_trace_automaton(pda, 0, pda.encode_pre(init_stack));
+        PAutomaton parallel_automaton(pda, 0, pda.encode_pre(init_stack));
+
+        Solver::post_star(automaton);
+        Solver::post_star<Trace_Type::None>(no_trace_automaton);
+        Solver::post_star_parallel<Trace_Type::None>(parallel_automaton, 4);
+
+        BOOST_CHECK_EQUAL(automaton.states().size(), no_trace_automaton.states().size());
+        auto edges = get_edges(automaton);
+        BOOST_CHECK(edges == get_edges(no_trace_automaton));
+        BOOST_CHECK(edges == get_edges(parallel_automaton));
+        for (const auto& from : no_trace_automaton.states()) {
+            for (const auto& [to,labels] : from->_edges) {
+                for (const auto& [label,trace] : labels) {
+                    BOOST_CHECK_EQUAL(trace_from<void>(trace), no_trace);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(IncrementalPreStarSameEdges)
+{
+    std::vector<std::vector<char>> stacks{{'A'}, {'B'}, {'C'}, {'A','B'}, {'C','A'}, {'B','B','A'}};
+    for (unsigned int seed = 0; seed < 10; ++seed) {
+        auto pda = random_pda(12, 40, seed);
+        auto incremental_pda = random_pda(12, 40, seed, 20);
+        std::vector<char> init_stack{'A', 'B'};
+        PAutomaton automaton(pda, 0, pda.encode_pre(init_stack));
+        PAutomaton incremental_automaton(incremental_pda, 0, incremental_pda.encode_pre(init_stack));
+
+        Solver::pre_star(automaton);
+        auto saturation = Solver::pre_star_incremental(incremental_automaton);
+        saturation.add_rules([&](){ add_random_rules(incremental_pda, 12, 40, seed, 20, 30); });
+        saturation.add_rules([&](){ add_random_rules(incremental_pda, 12, 40, seed, 30, 40); });
+
+        BOOST_CHECK(get_edges(automaton) == get_edges(incremental_automaton));
+        for (size_t state = 0; state < 12; ++state) {
+            for (const auto& stack : stacks) {
+                if (!incremental_automaton.accepts(state, incremental_pda.encode_pre(stack))) continue;
+                auto trace = Solver::get_trace(incremental_pda, incremental_automaton, state, stack);
+                BOOST_REQUIRE(!trace.empty());
+                BOOST_CHECK_EQUAL(trace.front()._pdastate, state);
+                BOOST_CHECK_EQUAL(trace.back()._pdastate, 0);
+                BOOST_CHECK(trace.back()._stack == init_stack);
+                BOOST_CHECK(valid_trace(incremental_pda, trace));
+            }
+        }
+    }
+}
+
+// Removes n random rules, and sometimes removes some labels from a rule instead.
+void remove_random_rules(TypedPDA<char>& pda, size_t n, unsigned int seed) {
+    std::mt19937 gen(seed);
+    auto& states = pda.states_mutable();
+    std::uniform_int_distribution<size_t> state_dist(0, states.size() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        auto& rules = states[state_dist(gen)]._rules;
+        if (rules.empty()) continue;
+        auto& [rule, labels] = rules[std::uniform_int_distribution<size_t>(0, rules.size() - 1)(gen)];
+        if (!labels.wildcard() && labels.labels().size() > 1) {
+            labels.intersect(std::vector<uint32_t>{labels.labels()[0]}, pda.number_of_labels());
+        } else {
+            auto r = rule;
+            rules.erase(r);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RemoveRulesPreStarSameEdges)
+{
+    std::vector<std::vector<char>> stacks{{'A'}, {'B'}, {'C'}, {'A','B'}, {'C','A'}, {'B','B','A'}};
+    for (unsigned int seed = 0; seed < 300; ++seed) {
+        auto pda = random_pda(12, 40, seed);
+        auto incremental_pda = random_pda(12, 40, seed);
+        std::vector<char> init_stack{'A', 'B'};
+        PAutomaton incremental_automaton(incremental_pda, 0, incremental_pda.encode_pre(init_stack));
+        auto saturation = Solver::pre_star_incremental(incremental_automaton);
+
+        saturation.remove_rules([&](){ remove_random_rules(incremental_pda, 6, seed); });
+        remove_random_rules(pda, 6, seed);
+        saturation.remove_rules([&](){ incremental_pda.clear_state(seed % 12); });
+        pda.clear_state(seed % 12);
+        // Remove and add rules in the same update.
+        saturation.remove_rules([&](){
+            remove_random_rules(incremental_pda, 3, seed + 100);
+            add_random_rules(incremental_pda, 12, 10, seed + 100);
+        });
+        remove_random_rules(pda, 3, seed + 100);
+        add_random_rules(pda, 12, 10, seed + 100);
+
+        PAutomaton automaton(pda, 0, pda.encode_pre(init_stack));
+        Solver::pre_star(automaton);
+        BOOST_CHECK(get_edges(automaton) == get_edges(incremental_automaton));
+        for (size_t state = 0; state < 12; ++state) {
+            for (const auto& stack : stacks) {
+                if (!incremental_automaton.accepts(state, incremental_pda.encode_pre(stack))) continue;
+                auto trace = Solver::get_trace(incremental_pda, incremental_automaton, state, stack);
+                BOOST_REQUIRE(!trace.empty());
+                BOOST_CHECK_EQUAL(trace.back()._pdastate, 0);
+                BOOST_CHECK(trace.back()._stack == init_stack);
+                BOOST_CHECK(valid_trace(incremental_pda, trace));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(IncrementalPostStarSameEdges)
+{
+    std::vector<std::vector<char>> stacks{{'A'}, {'B'}, {'C'}, {'A','B'}, {'C','A'}, {'B','B','A'}};
+    for (unsigned int seed = 0; seed < 10; ++seed) {
+        auto pda = random_pda(12, 40, seed);
+        auto incremental_pda = random_pda(12, 40, seed, 20);
+        std::vector<char> init_stack{'A', 'B'};
+        PAutomaton automaton(pda, 0, pda.encode_pre(init_stack));
+        PAutomaton incremental_automaton(incremental_pda, 0, incremental_pda.encode_pre(init_stack));
+
+        Solver::post_star(automaton);
+        auto saturation = Solver::post_star_incremental(incremental_automaton);
+        saturation.add_rules([&](){ add_random_rules(incremental_pda, 12, 40, seed, 20, 30); });
+        saturation.add_rules([&](){ add_random_rules(incremental_pda, 12, 40, seed, 30, 40); });
+
+        // Q' states may be numbered differently, so compare the accepted configurations instead of the edges.
+        for (size_t state = 0; state < 12; ++state) {
+            for (const auto& stack : stacks) {
+                auto accepted = automaton.accepts(state, pda.encode_pre(stack));
+                BOOST_CHECK_EQUAL(accepted, incremental_automaton.accepts(state, incremental_pda.encode_pre(stack)));
+                if (!accepted) continue;
+                auto trace = Solver::get_trace(incremental_pda, incremental_automaton, state, stack);
+                BOOST_REQUIRE(!trace.empty());
+                BOOST_CHECK_EQUAL(trace.front()._pdastate, 0);
+                BOOST_CHECK(trace.front()._stack == init_stack);
+                BOOST_CHECK_EQUAL(trace.back()._pdastate, state);
+                BOOST_CHECK(valid_trace(incremental_pda, trace));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ParallelEarlyTerminationPostStar)
+{
+    std::unordered_set<char> labels{'A', 'B', 'C'};
+    TypedPDA<char> pda(labels);
+    pda.add_rule(0, 1, PUSH, 'B', 'A');
+    pda.add_rule(0, 0, POP , '*', 'B');
+    pda.add_rule(1, 3, SWAP, 'A', 'B');
+    pda.add_rule(2, 0, SWAP, 'B', 'C');
+    pda.add_rule(3, 2, PUSH, 'C', 'A');
+
+    std::vector<char> init_stack{'A', 'A'};
+    PAutomaton automaton(pda, 0, pda.encode_pre(init_stack));
+
+    std::vector<char> test_stack_reachable{'B', 'A', 'A', 'A'};
+    auto result = Solver::post_star_parallel(automaton, 3);
+    BOOST_CHECK_EQUAL(result, false); // No early termination.
+    BOOST_CHECK(automaton.accepts(1, pda.encode_pre(test_stack_reachable)));
+
+    auto trace = Solver::get_trace(pda, automaton, 1, test_stack_reachable);
+    BOOST_REQUIRE(!trace.empty());
+    BOOST_CHECK_EQUAL(trace.front()._pdastate, 0);
+    BOOST_CHECK_EQUAL(trace.front()._stack.size(), 2);
+    BOOST_CHECK_EQUAL(trace.back()._pdastate, 1);
+    BOOST_CHECK_EQUAL(trace.back()._stack.size(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelEarlyTerminationPreStar)
+{
+    std::unordered_set<char> labels{'A', 'B', 'C'};
+    TypedPDA<char> pda(labels);
+    pda.add_rule(0, 1, PUSH, 'B', 'A');
+    pda.add_rule(0, 0, POP , '*', 'B');
+    pda.add_rule(1, 3, SWAP, 'A', 'B');
+    pda.add_rule(2, 0, SWAP, 'B', 'C');
+    pda.add_rule(3, 2, PUSH, 'C', 'A');
+
+    std::vector<char> init_stack{'B', 'A', 'A', 'A'};
+    PAutomaton automaton(pda, 1, pda.encode_pre(init_stack));
+
+    auto s_label = pda.encode_pre(std::vector<char>{'A'})[0];
+    auto result = Solver::pre_star_parallel<Trace_Type::Any,void,std::less<void>,add<void>,true>(automaton, 3, [&automaton, s_label](size_t from, uint32_t label, size_t to, trace_ptr<void> trace) -> bool {
+        return from == 0 && label == s_label && automaton.states()[to]->_accepting;
+    });
+    BOOST_CHECK_EQUAL(result, true);
+
+    std::vector<char> test_stack_reachable{'A'};
+    auto trace = Solver::get_trace(pda, automaton, 0, test_stack_reachable);
+    BOOST_REQUIRE(!trace.empty());
+    BOOST_CHECK_EQUAL(trace.front()._pdastate, 0);
+    BOOST_CHECK_EQUAL(trace.back()._pdastate, 1);
+    BOOST_CHECK_EQUAL(trace.back()._stack.size(), 4);
+}
+
+// Reachability from <0, [A,B]> to <final_state, w> in pda for the stacks w accepted by final, answered by solve(instance).
+template <typename W, typename Fn>
+auto reachability(TypedPDA<char,W>&& pda, const NFA<char>& final, size_t final_state, Fn&& solve) {
+    NFA<char> initial(std::unordered_set<char>{'A'});
+    initial.concat(NFA<char>(std::unordered_set<char>{'B'}));
+    initial.compile();
+    SolverInstance<char,W,std::less<W>,add<W>> instance(std::move(pda), initial, {0}, final, {final_state});
+    return solve(instance);
+}
+// The final stacks [] and [C].
+NFA<char> empty_or_c_stack() {
+    NFA<char> final(std::unordered_set<char>{'C'});
+    final.question_extend();
+    final.compile();
+    return final;
+}
+// The final stacks [x] for any label x. This gives a wildcard edge in the final automaton.
+NFA<char> any_label_stack() {
+    NFA<char> final(std::unordered_set<char>{}, true);
+    final.compile();
+    return final;
+}
+
+// Reachability from <0, [A,B]> to <final_state, []> or <final_state, [C]> in a random PDA, answered by solve(instance).
+template <typename Fn>
+auto random_reachability(unsigned int seed, size_t final_state, Fn&& solve) {
+    return reachability(random_pda(12, 40, seed), empty_or_c_stack(), final_state, std::forward<Fn>(solve));
+}
+
+BOOST_AUTO_TEST_CASE(DualSearchSchedules)
+{
+    size_t n_accepted = 0;
+    for (unsigned int seed = 0; seed < 20; ++seed) {
+        auto final_state = seed % 12;
+        bool expected = random_reachability(seed, final_state, [](auto& instance){ return Solver::pre_star_accepts(instance); });
+        n_accepted += expected ? 1 : 0;
+        BOOST_CHECK_EQUAL(random_reachability(seed, final_state, [](auto& instance){
+            return Solver::dual_search_accepts<dual_search_schedule::alternate>(instance); }), expected);
+        BOOST_CHECK_EQUAL(random_reachability(seed, final_state, [](auto& instance){
+            return Solver::dual_search_accepts<dual_search_schedule::workset_size>(instance); }), expected);
+        BOOST_CHECK_EQUAL(random_reachability(seed, final_state, [](auto& instance){
+            return Solver::dual_search_accepts<dual_search_schedule::edge_count>(instance); }), expected);
+        BOOST_CHECK_EQUAL(random_reachability(seed, final_state, [](auto& instance){
+            return Solver::dual_search_accepts<dual_search_schedule::time_slice<0>>(instance); }), expected);
+        BOOST_CHECK_EQUAL(random_reachability(seed, final_state, [](auto& instance){
+            return Solver::dual_search_accepts<dual_search_schedule::time_slice<>>(instance); }), expected);
+    }
+    BOOST_CHECK_GT(n_accepted, 0);
+    BOOST_CHECK_LT(n_accepted, 20);
+}
+
+// Reachability from <0, [A,B]> to <final_state, [x]> for any label x in a random PDA, for the parallel dual search.
+// The final automaton has a wildcard edge, which the products built by the two threads must handle.
+template <typename Fn>
+auto random_reachability_any_label(unsigned int seed, size_t final_state, Fn&& solve) {
+    return reachability(random_pda(12, 40, seed), any_label_stack(), final_state, std::forward<Fn>(solve));
+}
+
+BOOST_AUTO_TEST_CASE(ParallelDualSearch)
+{
+    size_t n_accepted = 0;
+    for (unsigned int seed = 0; seed < 40; ++seed) {
+        auto final_state = seed % 12;
+        bool expected = random_reachability_any_label(seed, final_state, [](auto& instance){ return Solver::pre_star_accepts(instance); });
+        n_accepted += expected ? 1 : 0;
+        for (size_t i = 0; i < 5; ++i) { // Repeat, since the interleaving of the threads differs between runs.
+            BOOST_CHECK_EQUAL(random_reachability_any_label(seed, final_state, [final_state](auto& instance){
+                bool result = Solver::dual_search_accepts_parallel(instance);
+                if (result) {
+                    auto trace = Solver::get_trace_dual_search(instance);
+                    BOOST_REQUIRE(!trace.empty());
+                    BOOST_CHECK_EQUAL(trace.front()._pdastate, 0);
+                    BOOST_CHECK_EQUAL(trace.back()._pdastate, final_state);
+                    BOOST_CHECK_EQUAL(trace.back()._stack.size(), 1);
+                    BOOST_CHECK(valid_trace(instance.pda(), trace));
+                }
+                return result; }), expected);
+        }
+        // The same answer for the final configurations of random_reachability, where the final stack may be empty.
+        bool expected_c = random_reachability(seed, final_state, [](auto& instance){ return Solver::pre_star_accepts(instance); });
+        BOOST_CHECK_EQUAL(random_reachability(seed, final_state, [final_state](auto& instance){
+            bool result = Solver::dual_search_accepts_parallel(instance);
+            if (result) {
+                auto trace = Solver::get_trace_dual_search(instance);
+                BOOST_REQUIRE(!trace.empty());
+                BOOST_CHECK_EQUAL(trace.back()._pdastate, final_state);
+                BOOST_CHECK(valid_trace(instance.pda(), trace));
+            }
+            return result; }), expected_c);
+    }
+    BOOST_CHECK_GT(n_accepted, 0);
+}
+
+// A trace that pops the whole stack ends in a configuration with an empty stack.
+// (post_star_accepts does not find final configurations with an empty stack, so only pre* and dual search are checked.)
+BOOST_AUTO_TEST_CASE(TraceToEmptyStack)
+{
+    auto make_instance = []() {
+        std::unordered_set<char> labels{'A', 'B'};
+        TypedPDA<char> pda(labels);
+        pda.add_rule(0, 1, SWAP, 'B', 'A');
+        pda.add_rule(1, 2, POP, '*', 'B');
+        NFA<char> initial(std::unordered_set<char>{'A'});
+        NFA<char> final(std::unordered_set<char>{'A'});
+        final.question_extend();
+        initial.compile();
+        final.compile();
+        return SolverInstance<char,void,std::less<void>,add<void>>(std::move(pda), initial, {0}, final, {2});
+    };
+    auto check_trace = [](const auto& instance, const auto& trace) {
+        BOOST_REQUIRE_EQUAL(trace.size(), 3);
+        BOOST_CHECK_EQUAL(trace.front()._pdastate, 0);
+        BOOST_CHECK_EQUAL(trace.back()._pdastate, 2);
+        BOOST_CHECK(trace.back()._stack.empty());
+        BOOST_CHECK(valid_trace(instance.pda(), trace));
+    };
+    {
+        auto instance = make_instance();
+        BOOST_REQUIRE(Solver::pre_star_accepts(instance));
+        check_trace(instance, Solver::get_trace(instance));
+    }
+    {
+        auto instance = make_instance();
+        BOOST_REQUIRE(Solver::dual_search_accepts(instance));
+        check_trace(instance, Solver::get_trace_dual_search(instance));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SaturationStatistics)
+{
+    for (unsigned int seed = 0; seed < 20; ++seed) {
+        auto final_state = seed % 12;
+        bool expected = random_reachability(seed, final_state, [](auto& instance){ return Solver::pre_star_accepts(instance); });
+        saturation_stats pre_stats, post_stats;
+        BOOST_CHECK_EQUAL(random_reachability(seed, final_state, [&pre_stats](auto& instance){
+            return Solver::pre_star_accepts(instance, pre_stats); }), expected);
+        BOOST_CHECK_EQUAL(random_reachability(seed, final_state, [&post_stats](auto& instance){
+            return Solver::post_star_accepts(instance, post_stats); }), expected);
+        for (const auto& stats : {pre_stats, post_stats}) {
+            BOOST_CHECK_GT(stats.edges_inserted, 0);
+            BOOST_CHECK_LE(stats.steps, stats.edges_inserted);
+            BOOST_CHECK_LE(stats.peak_workset, stats.edges_inserted);
+            BOOST_CHECK_LE(stats.rules_matched, stats.rules_scanned);
+            BOOST_CHECK_EQUAL(stats.stale_pops, 0);
+        }
+        BOOST_CHECK_EQUAL(pre_stats.q_prime_states, 0);
+        BOOST_CHECK_GT(post_stats.q_prime_states, 0);
+        BOOST_CHECK_GT(pre_stats.traces, 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SaturationStatisticsShortest)
+{
+    std::unordered_set<char> labels{'A', 'B'};
+    TypedPDA<char, uint32_t> pda(labels);
+    pda.add_rule(0, 1, PUSH, 'B', 'A', 1);
+    pda.add_rule(0, 2, SWAP, 'B', 'A', 5);
+    pda.add_rule(1, 2, SWAP, 'A', 'B', 1);
+    pda.add_rule(2, 0, POP, '*', 'A', 1);
+    pda.add_rule(2, 3, NOOP, '*', 'B', 1);
+    NFA<char> initial(std::unordered_set<char>{'A'});
+    NFA<char> final(std::unordered_set<char>{'B'});
+    initial.compile();
+    final.compile();
+    SolverInstance<char,uint32_t,std::less<uint32_t>,add<uint32_t>> instance(std::move(pda), initial, {0}, final, {3});
+    saturation_stats stats;
+    BOOST_CHECK(Solver::post_star_accepts<Trace_Type::Shortest>(instance, stats));
+    BOOST_CHECK_GT(stats.steps, 0);
+    BOOST_CHECK_GT(stats.rules_matched, 0);
+    BOOST_CHECK_LE(stats.rules_matched, stats.rules_scanned);
+    BOOST_CHECK_EQUAL(stats.q_prime_states, 1);
+    BOOST_CHECK_GT(stats.traces, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GovernorLimits)
+{
+    auto pda = random_pda(50, 600, 7);
+    auto initial_stack = pda.encode_pre(std::vector<char>{'A', 'B'});
+    {
+        std::atomic<bool> cancel = true;
+        governor limits;
+        limits.set_cancel_flag(&cancel);
+        PAutomaton automaton(pda, 0, initial_stack);
+        BOOST_CHECK(Solver::pre_star(automaton, limits) == solver_result::unknown);
+        BOOST_CHECK(limits.reason() == governor::reason_t::cancelled);
+    }
+    {
+        governor limits;
+        limits.set_memory_budget(1);
+        PAutomaton automaton(pda, 0, initial_stack);
+        BOOST_CHECK(Solver::post_star(automaton, limits) == solver_result::unknown);
+        BOOST_CHECK(limits.reason() == governor::reason_t::memory);
+    }
+    {
+        governor limits;
+        limits.set_deadline(governor::clock::now());
+        PAutomaton pre_automaton(pda, 0, initial_stack);
+        PAutomaton post_automaton(pda, 0, initial_stack);
+        auto never = [](size_t, uint32_t, size_t, trace_ptr<void>) -> bool { return false; };
+        BOOST_CHECK(Solver::dual_search(pre_automaton, post_automaton, never, never, limits) == solver_result::unknown);
+        BOOST_CHECK(limits.reason() == governor::reason_t::deadline);
+    }
+    {
+        governor limits;
+        limits.set_timeout(std::chrono::hours(1)).set_memory_budget(size_t(1) << 30);
+        PAutomaton automaton(pda, 0, initial_stack);
+        PAutomaton expected(pda, 0, initial_stack);
+        Solver::pre_star(expected);
+        BOOST_CHECK(Solver::pre_star(automaton, limits) == solver_result::no);
+        BOOST_CHECK(!limits.stopped());
+        BOOST_CHECK_EQUAL(automaton.states().size(), expected.states().size());
+        for (size_t s = 0; s < expected.states().size(); ++s) {
+            BOOST_CHECK_EQUAL(automaton.states()[s]->_edges.size(), expected.states()[s]->_edges.size());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GovernorAccepts)
+{
+    for (unsigned int seed = 0; seed < 20; ++seed) {
+        auto final_state = seed % 12;
+        bool accepted = random_reachability(seed, final_state, [](auto& instance){ return Solver::pre_star_accepts(instance); });
+        auto expected = accepted ? solver_result::yes : solver_result::no;
+        governor limits;
+        limits.set_timeout(std::chrono::hours(1));
+        BOOST_CHECK(random_reachability(seed, final_state, [&limits](auto& instance){ return Solver::pre_star_accepts(instance, limits); }) == expected);
+        BOOST_CHECK(random_reachability(seed, final_state, [&limits](auto& instance){ return Solver::post_star_accepts(instance, limits); }) == expected);
+        BOOST_CHECK(random_reachability(seed, final_state, [&limits](auto& instance){ return Solver::dual_search_accepts(instance, limits); }) == expected);
+        BOOST_CHECK(!limits.stopped());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RuleIndexMatchesRules)
+{
+    for (unsigned int seed = 0; seed < 10; ++seed) {
+        auto pda = random_pda(10, 200, seed);
+        details::rule_index index(pda.states());
+        for (size_t state = 0; state < pda.states().size(); ++state) {
+            const auto& rules = pda.states()[state]._rules;
+            for (uint32_t label = 0; label < pda.number_of_labels(); ++label) {
+                std::vector<size_t> expected, actual;
+                for (size_t rule_id = 0; rule_id < rules.size(); ++rule_id) {
+                    if (rules[rule_id].second.contains(label)) {
+                        expected.push_back(rule_id);
+                    }
+                }
+                index.for_each_rule(state, label, [&actual](size_t rule_id) { actual.push_back(rule_id); });
+                BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(QPrimeTableKeepsIndices)
+{
+    auto pda = random_pda(10, 100, 3);
+    using q_prime_t = std::map<std::pair<size_t,uint32_t>,size_t>;
+    auto check = [&pda](const details::q_prime_table& table) {
+        q_prime_t q_prime; // (p', y1) -> index must be a bijection onto 0..size-1.
+        const auto& states = pda.states();
+        for (size_t state = 0; state < states.size(); ++state) {
+            for (size_t rule_id = 0; rule_id < states[state]._rules.size(); ++rule_id) {
+                const auto& rule = states[state]._rules[rule_id].first;
+                auto index = table(state, rule_id);
+                if (rule._operation != PUSH) {
+                    BOOST_CHECK_EQUAL(index, details::q_prime_table::no_state);
+                    continue;
+                }
+                BOOST_CHECK_LT(index, table.size());
+                auto [it, fresh] = q_prime.emplace(std::make_pair(rule._to, rule._op_label), index);
+                BOOST_CHECK_EQUAL(it->second, index);
+            }
+        }
+        BOOST_CHECK_EQUAL(q_prime.size(), table.size());
+        return q_prime;
+    };
+    details::q_prime_table table(pda.states());
+    auto before = check(table);
+    add_random_rules(pda, 10, 100, 4);
+    table.update(pda.states());
+    auto after = check(table);
+    for (const auto& [key, index] : before) {
+        BOOST_CHECK_EQUAL(after[key], index);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CompiledPDASharedBetweenSolves)
+{
+    auto pda = random_pda(12, 120, 5);
+    auto compiled = compile_pda(pda);
+    BOOST_CHECK(compiled->matches(pda));
+    size_t n_rules = 0;
+    for (const auto& state : pda.states()) {
+        n_rules += state._rules.size();
+    }
+    BOOST_CHECK_EQUAL(compiled->number_of_rules(), n_rules);
+    auto same_edges = [](const auto& automaton, const auto& expected) {
+        BOOST_CHECK_EQUAL(automaton.states().size(), expected.states().size());
+        for (size_t s = 0; s < expected.states().size(); ++s) {
+            BOOST_CHECK_EQUAL(automaton.states()[s]->_edges.size(), expected.states()[s]->_edges.size());
+        }
+    };
+    for (const auto& stack : {std::vector<char>{'A'}, std::vector<char>{'B', 'A'}, std::vector<char>{'C', 'B', 'A'}}) {
+        auto initial_stack = pda.encode_pre(stack);
+        for (size_t initial_state = 0; initial_state < 3; ++initial_state) {
+            PAutomaton pre_automaton(pda, initial_state, initial_stack);
+            PAutomaton pre_expected(pda, initial_state, initial_stack);
+            Solver::pre_star(pre_automaton, compiled);
+            Solver::pre_star(pre_expected);
+            same_edges(pre_automaton, pre_expected);
+            PAutomaton post_automaton(pda, initial_state, initial_stack);
+            PAutomaton post_expected(pda, initial_state, initial_stack);
+            Solver::post_star(post_automaton, compiled);
+            Solver::post_star(post_expected);
+            same_edges(post_automaton, post_expected);
+        }
+    }
+    for (unsigned int seed = 0; seed < 10; ++seed) {
+        auto final_state = seed % 12;
+        bool expected = random_reachability(seed, final_state, [](auto& instance){ return Solver::pre_star_accepts(instance); });
+        auto compiled_instance = compile_pda(random_pda(12, 40, seed));
+        BOOST_CHECK_EQUAL(random_reachability(seed, final_state, [&compiled_instance](auto& instance){
+            return Solver::pre_star_accepts(instance, compiled_instance); }), expected);
+        BOOST_CHECK_EQUAL(random_reachability(seed, final_state, [&compiled_instance](auto& instance){
+            return Solver::post_star_accepts(instance, compiled_instance); }), expected);
+    }
+    auto other = random_pda(8, 120, 5);
+    PAutomaton automaton(other, 0, other.encode_pre(std::vector<char>{'A'}));
+    BOOST_CHECK_THROW(Solver::pre_star(automaton, compiled), std::logic_error);
+
+    // Same number of states and rules, but a different precondition.
+    std::unordered_set<char> labels{'A', 'B'};
+    TypedPDA<char> pda_a(labels);
+    pda_a.add_rule(0, 1, POP, 'A', 'A');
+    TypedPDA<char> pda_b(labels);
+    pda_b.add_rule(0, 1, POP, 'A', 'B');
+    BOOST_CHECK(compile_pda(pda_a)->same_rules(pda_a));
+    BOOST_CHECK(compile_pda(pda_a)->matches(pda_b));
+    BOOST_CHECK(!compile_pda(pda_a)->same_rules(pda_b));
+}
+
+BOOST_AUTO_TEST_CASE(CompiledPDACachedInPDA)
+{
+    auto pda = random_pda(12, 40, 3);
+    auto compiled = compile_pda(pda);
+    BOOST_CHECK(compile_pda(pda) == compiled);
+    pda.add_rule(0, 12, PUSH, 'A', 'B');
+    auto recompiled = compile_pda(pda);
+    BOOST_CHECK(recompiled != compiled);
+    BOOST_CHECK(recompiled->same_rules(pda));
+    BOOST_CHECK(!compiled->matches(pda));
+}
+
+// Early termination predicate that cannot be stored in a std::function, so the solver must call it directly.
+struct counting_early_termination {
+    explicit counting_early_termination(size_t state) : _state(state) {}
+    counting_early_termination(const counting_early_termination&) = delete;
+    bool operator()(size_t from, uint32_t, size_t, trace_ptr<void>) const {
+        ++_calls;
+        return from == _state;
+    }
+    size_t _state;
+    mutable size_t _calls = 0;
+};
+
+BOOST_AUTO_TEST_CASE(TemplateEarlyTermination)
+{
+    auto pda = random_pda(12, 40, 3);
+    auto initial_stack = pda.encode_pre(std::vector<char>{'A', 'B'});
+    for (size_t state = 0; state < 12; ++state) {
+        details::early_termination_fn<void> erased = [state](size_t from, uint32_t, size_t, trace_ptr<void>) { return from == state; };
+        PAutomaton pre_expected(pda, 0, initial_stack);
+        PAutomaton post_expected(pda, 0, initial_stack);
+        bool pre_found = Solver::pre_star<Trace_Type::Any,void,std::less<void>,add<void>,true>(pre_expected, erased);
+        bool post_found = Solver::post_star<Trace_Type::Any,void,std::less<void>,add<void>,true>(post_expected, erased);
+
+        counting_early_termination pre_et(state), post_et(state);
+        PAutomaton pre_automaton(pda, 0, initial_stack);
+        PAutomaton post_automaton(pda, 0, initial_stack);
+        BOOST_CHECK_EQUAL((Solver::pre_star<Trace_Type::Any,void,std::less<void>,add<void>,true>(pre_automaton, pre_et)), pre_found);
+        BOOST_CHECK_EQUAL((Solver::post_star<Trace_Type::Any,void,std::less<void>,add<void>,true>(post_automaton, post_et)), post_found);
+        BOOST_CHECK_GT(pre_et._calls + post_et._calls, 0);
+
+        counting_early_termination dual_pre_et(state), dual_post_et(state);
+        PAutomaton dual_pre_automaton(pda, 0, initial_stack);
+        PAutomaton dual_post_automaton(pda, 0, initial_stack);
+        Solver::dual_search(dual_pre_automaton, dual_post_automaton, dual_pre_et, dual_post_et);
+        BOOST_CHECK_GT(dual_pre_et._calls + dual_post_et._calls, 0);
+    }
+}
+
+// Random PDA with rule weights in 0..4, using the same random choices as add_random_rules.
+TypedPDA<char,uint32_t> random_weighted_pda(size_t n_states, size_t n_rules, unsigned int seed) {
+    std::vector<char> label_list{'A', 'B', 'C'};
+    std::vector<op_t> ops{PUSH, POP, SWAP, NOOP};
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<size_t> state_dist(0, n_states - 1);
+    std::uniform_int_distribution<size_t> label_dist(0, label_list.size() - 1);
+    std::uniform_int_distribution<size_t> op_dist(0, ops.size() - 1);
+    std::uniform_int_distribution<uint32_t> weight_dist(0, 4);
+    TypedPDA<char,uint32_t> pda(std::unordered_set<char>(label_list.begin(), label_list.end()));
+    for (size_t i = 0; i < n_rules; ++i) {
+        auto from = state_dist(gen);
+        auto to = state_dist(gen);
+        auto op = ops[op_dist(gen)];
+        auto op_label = label_list[label_dist(gen)];
+        bool wildcard = label_dist(gen) == 0;
+        auto pre = label_list[label_dist(gen)];
+        auto weight = weight_dist(gen);
+        if (wildcard) {
+            pda.add_rule(from, to, op, op_label, true, std::vector<char>(), weight);
+        } else {
+            pda.add_rule(from, to, op, op_label, pre, weight);
+        }
+    }
+    pda.add_rule(n_states - 1, n_states - 1, NOOP, 'A', 'A', 0); // Make sure all states exist.
+    return pda;
+}
+
+// Weighted reachability from <0, [A,B]> to <final_state, [x]> for any label x in a random PDA, answered by solve(instance).
+template <typename Fn>
+auto random_weighted_reachability(unsigned int seed, size_t final_state, Fn&& solve) {
+    return reachability(random_weighted_pda(10, 40, seed), any_label_stack(), final_state, std::forward<Fn>(solve));
+}
+
+BOOST_AUTO_TEST_CASE(PreStarShortest)
+{
+    size_t n_reachable = 0;
+    for (unsigned int seed = 0; seed < 40; ++seed) {
+        auto final_state = seed % 10;
+        using result_t = std::pair<bool, uint32_t>;
+        auto post = random_weighted_reachability(seed, final_state, [](auto& instance) -> result_t {
+            if (!Solver::post_star_accepts_no_ET<Trace_Type::Shortest>(instance)) return {false, 0};
+            return {true, Solver::get_trace<Trace_Type::Shortest>(instance).second};
+        });
+        auto pre = random_weighted_reachability(seed, final_state, [final_state](auto& instance) -> result_t {
+            if (!Solver::pre_star_accepts_no_ET<Trace_Type::Shortest>(instance)) return {false, 0};
+            auto [trace, weight] = Solver::get_trace<Trace_Type::Shortest>(instance);
+            BOOST_CHECK(!trace.empty());
+            if (!trace.empty()) {
+                BOOST_CHECK_EQUAL(trace.front()._pdastate, 0);
+                BOOST_CHECK_EQUAL(trace.back()._pdastate, final_state);
+                BOOST_CHECK_EQUAL(trace.back()._stack.size(), 1);
+            }
+            return {true, weight};
+        });
+        BOOST_CHECK_EQUAL(pre.first, post.first);
+        BOOST_CHECK_EQUAL(pre.second, post.second);
+        n_reachable += post.first ? 1 : 0;
+
+        saturation_stats stats;
+        BOOST_CHECK_EQUAL(random_weighted_reachability(seed, final_state, [&stats](auto& instance) {
+            return Solver::pre_star_accepts<Trace_Type::Shortest>(instance, stats); }), post.first);
+        BOOST_CHECK_GT(stats.steps, 0);
+        BOOST_CHECK(random_weighted_reachability(seed, final_state, [](auto& instance) {
+            governor limits;
+            return Solver::pre_star_accepts<Trace_Type::Shortest>(instance, limits); }) == (post.first ? solver_result::yes : solver_result::no));
+    }
+    BOOST_CHECK_GT(n_reachable, 0);
+    BOOST_CHECK_LT(n_reachable, 40);
+}
+
+BOOST_AUTO_TEST_CASE(KShortestTracesPreAndPostStar)
+{
+    constexpr size_t k = 6;
+    size_t n_reachable = 0;
+    for (unsigned int seed = 0; seed < 40; ++seed) {
+        auto final_state = seed % 10;
+        auto pda = random_weighted_pda(10, 40, seed);
+        std::vector<char> initial_stack{'A', 'B'}, final_stack{'A'};
+
+        PAutomaton post_automaton(pda, 0, pda.encode_pre(initial_stack));
+        Solver::post_star<Trace_Type::Shortest>(post_automaton);
+        auto post_traces = Solver::post_star_shortest_traces(pda, post_automaton, final_state, final_stack).take(k);
+
+        PAutomaton pre_automaton(pda, final_state, pda.encode_pre(final_stack));
+        Solver::pre_star<Trace_Type::Shortest,uint32_t,std::less<uint32_t>,add<uint32_t>,false>(pre_automaton);
+        auto pre_traces = Solver::pre_star_shortest_traces(pda, pre_automaton, 0, initial_stack).take(k);
+
+        BOOST_CHECK_EQUAL(post_traces.size(), pre_traces.size());
+        if (post_traces.empty()) continue;
+        ++n_reachable;
+        // The cheapest trace has the same weight as the one found by get_trace.
+        BOOST_CHECK_EQUAL(post_traces[0].second, Solver::get_trace<Trace_Type::Shortest>(pda, post_automaton, final_state, final_stack).second);
+        for (size_t i = 0; i < std::min(post_traces.size(), pre_traces.size()); ++i) {
+            // Both directions enumerate the same traces, though traces of equal weight may come in a different order.
+            BOOST_CHECK_EQUAL(post_traces[i].second, pre_traces[i].second);
+            if (i > 0) {
+                BOOST_CHECK_LE(post_traces[i - 1].second, post_traces[i].second);
+            }
+            for (const auto& trace : {post_traces[i].first, pre_traces[i].first}) {
+                BOOST_CHECK(valid_trace(pda, trace));
+                BOOST_CHECK_EQUAL(trace.front()._pdastate, 0);
+                BOOST_CHECK(trace.front()._stack == initial_stack);
+                BOOST_CHECK_EQUAL(trace.back()._pdastate, final_state);
+                BOOST_CHECK(trace.back()._stack == final_stack);
+            }
+        }
+        for (const auto& traces : {post_traces, pre_traces}) {
+            std::set<std::vector<std::pair<size_t,std::vector<char>>>> distinct;
+            for (const auto& [trace, weight] : traces) {
+                std::vector<std::pair<size_t,std::vector<char>>> configurations;
+                for (const auto& trace_state : trace) {
+                    configurations.emplace_back(trace_state._pdastate, trace_state._stack);
+                }
+                distinct.emplace(std::move(configurations));
+            }
+            BOOST_CHECK_EQUAL(distinct.size(), traces.size());
+        }
+    }
+    BOOST_CHECK_GT(n_reachable, 0);
+
+    // Rules that only differ in weight give the same trace, which is found once with the lowest weight.
+    TypedPDA<char,uint32_t> pda(std::unordered_set<char>{'A'});
+    pda.add_rule(0, 1, NOOP, 'A', 'A', 2);
+    pda.add_rule(0, 1, NOOP, 'A', 'A', 1);
+    PAutomaton automaton(pda, 0, pda.encode_pre(std::vector<char>{'A'}));
+    Solver::post_star<Trace_Type::Shortest>(automaton);
+    auto traces = Solver::post_star_shortest_traces(pda, automaton, 1, std::vector<char>{'A'}).take(k);
+    BOOST_REQUIRE_EQUAL(traces.size(), 1);
+    BOOST_CHECK_EQUAL(traces[0].second, 1);
+    BOOST_CHECK(valid_trace(pda, traces[0].first));
+}
+
+BOOST_AUTO_TEST_CASE(CompiledPDAShortestPostStar)
+{
+    for (unsigned int seed = 0; seed < 20; ++seed) {
+        auto final_state = seed % 10;
+        auto pda = random_weighted_pda(10, 40, seed);
+        std::vector<char> initial_stack{'A', 'B'}, final_stack{'A'};
+        PAutomaton automaton(pda, 0, pda.encode_pre(initial_stack));
+        PAutomaton expected(pda, 0, pda.encode_pre(initial_stack));
+        Solver::post_star<Trace_Type::Shortest>(automaton, compile_pda(pda));
+        Solver::post_star<Trace_Type::Shortest>(expected);
+        auto [trace, weight] = Solver::get_trace<Trace_Type::Shortest>(pda, automaton, final_state, final_stack);
+        auto [expected_trace, expected_weight] = Solver::get_trace<Trace_Type::Shortest>(pda, expected, final_state, final_stack);
+        BOOST_CHECK_EQUAL(trace.empty(), expected_trace.empty());
+        BOOST_CHECK_EQUAL(weight, expected_weight);
+    }
+}
+
+// Configurations reachable from <state, stack> by traces where no configuration has stack height above max_height.
+std::set<std::pair<size_t,std::vector<uint32_t>>> bounded_reachable(const TypedPDA<char>& pda, size_t state, const std::vector<uint32_t>& stack, size_t max_height) {
+    std::set<std::pair<size_t,std::vector<uint32_t>>> reachable{{state, stack}};
+    std::vector<std::pair<size_t,std::vector<uint32_t>>> waiting{{state, stack}};
+    while (!waiting.empty()) {
+        auto [p, w] = waiting.back();
+        waiting.pop_back();
+        if (w.empty()) continue;
+        for (const auto& [rule, labels] : pda.states()[p]._rules) {
+            if (!labels.contains(w[0])) continue;
+            std::vector<uint32_t> next(w.begin() + 1, w.end());
+            switch (rule._operation) {
+                case POP: break;
+                case SWAP: next.insert(next.begin(), rule._op_label); break;
+                case NOOP: next.insert(next.begin(), w[0]); break;
+                case PUSH: next.insert(next.begin(), {rule._op_label, w[0]}); break;
+            }
+            if (next.size() <= max_height && reachable.emplace(rule._to, next).second) {
+                waiting.emplace_back(rule._to, next);
+            }
+        }
+    }
+    return reachable;
+}
+
+BOOST_AUTO_TEST_CASE(BoundedHeightPreAndPostStar)
+{
+    constexpr size_t n_states = 6;
+    constexpr size_t max_height = 3;
+    for (unsigned int seed = 0; seed < 20; ++seed) {
+        auto pda = random_pda(n_states, 20, seed);
+        BoundedHeightPDA bounded(pda, max_height);
+        std::vector<uint32_t> initial_stack = pda.encode_pre(std::vector<char>{'A', 'B'});
+        auto reachable = bounded_reachable(pda, 0, initial_stack, max_height);
+
+        auto post_automaton = bounded.bounded_automaton(PAutomaton(pda, 0, initial_stack));
+        Solver::post_star(post_automaton);
+        // All configurations with stack height at most max_height.
+        std::vector<std::vector<uint32_t>> stacks{{}};
+        for (size_t i = 0; i < stacks.size(); ++i) {
+            if (stacks[i].size() == max_height) continue;
+            for (uint32_t label = 0; label < pda.number_of_labels(); ++label) {
+                auto stack = stacks[i];
+                stack.push_back(label);
+                stacks.push_back(stack);
+            }
+        }
+        for (size_t p = 0; p < n_states; ++p) {
+            for (const auto& stack : stacks) {
+                if (stack.empty()) continue; // PAutomaton::accepts does not follow the epsilon edges that post* uses for empty stacks.
+                BOOST_CHECK_EQUAL(bounded.accepts(post_automaton, p, stack), reachable.count({p, stack}) > 0);
+            }
+        }
+        // Configurations above the bound are not accepted, even if they are reachable without the bound.
+        BOOST_CHECK(!bounded.accepts(post_automaton, 0, std::vector<uint32_t>(max_height + 1, 0)));
+
+        for (const auto& [p, stack] : reachable) {
+            if (stack.empty()) continue;
+            auto trace = Solver::get_trace(pda, post_automaton, bounded.state(p, stack.size()), stack);
+            for (auto& trace_state : trace) {
+                BOOST_CHECK_LE(trace_state._stack.size(), max_height);
+                trace_state._pdastate = bounded.pda_state(trace_state._pdastate);
+            }
+            BOOST_CHECK(valid_trace(pda, trace));
+            BOOST_CHECK_EQUAL(trace.front()._pdastate, 0);
+            BOOST_CHECK_EQUAL(trace.back()._pdastate, p);
+        }
+
+        // pre* from a reachable and an unreachable target.
+        for (size_t target = 0; target < n_states; ++target) {
+            std::vector<uint32_t> target_stack{0};
+            auto pre_automaton = bounded.bounded_automaton(PAutomaton(pda, target, target_stack));
+            Solver::pre_star(pre_automaton);
+            BOOST_CHECK_EQUAL(bounded.accepts(pre_automaton, 0, initial_stack), reachable.count({target, target_stack}) > 0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(WorksetPoliciesSameEdges)
+{
+    for (unsigned int seed = 0; seed < 10; ++seed) {
+        auto pda = random_pda(12, 40, seed);
+        std::vector<char> init_stack{'A', 'B'};
+        auto check_pre = [&](auto&& saturate) {
+            PAutomaton automaton(pda, 0, pda.encode_pre(init_stack));
+            PAutomaton workset_automaton(pda, 0, pda.encode_pre(init_stack));
+            Solver::pre_star(automaton);
+            saturate(workset_automaton);
+            BOOST_CHECK(get_edges(automaton) == get_edges(workset_automaton));
+        };
+        auto check_post = [&](auto&& saturate) {
+            PAutomaton automaton(pda, 0, pda.encode_pre(init_stack));
+            PAutomaton workset_automaton(pda, 0, pda.encode_pre(init_stack));
+            Solver::post_star(automaton);
+            saturate(workset_automaton);
+            BOOST_CHECK(get_edges(automaton) == get_edges(workset_automaton));
+        };
+        check_pre([](auto& automaton) { Solver::pre_star_with_workset<fifo_workset>(automaton); });
+        check_pre([](auto& automaton) { Solver::pre_star_with_workset<ring_workset>(automaton); });
+        check_post([](auto& automaton) { Solver::post_star_with_workset<lifo_workset>(automaton); });
+        check_post([](auto& automaton) { Solver::post_star_with_workset<ring_workset>(automaton); });
+    }
+    for (unsigned int seed = 0; seed < 20; ++seed) {
+        auto final_state = seed % 12;
+        bool expected = random_reachability(seed, final_state, [](auto& instance){ return Solver::post_star_accepts(instance); });
+        BOOST_CHECK_EQUAL(random_reachability(seed, final_state, [](auto& instance){
+            return Solver::post_star_accepts_goal_directed(instance); }), expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FusedProductSameAnswer)
+{
+    size_t n_accepted = 0;
+    for (unsigned int seed = 0; seed < 20; ++seed) {
+        auto final_state = seed % 12;
+        bool expected = random_reachability(seed, final_state, [](auto& instance){ return Solver::pre_star_accepts(instance); });
+        n_accepted += expected ? 1 : 0;
+        auto check_trace = [final_state](auto& instance, bool result) {
+            if (result) {
+                auto trace = Solver::get_trace(instance);
+                BOOST_REQUIRE(!trace.empty());
+                BOOST_CHECK_EQUAL(trace.front()._pdastate, 0);
+                BOOST_CHECK_EQUAL(trace.back()._pdastate, final_state);
+                BOOST_CHECK(valid_trace(instance.pda(), trace));
+            }
+            return result;
+        };
+        BOOST_CHECK_EQUAL(random_reachability(seed, final_state, [&check_trace](auto& instance){
+            return check_trace(instance, Solver::pre_star_accepts_fused(instance)); }), expected);
+        BOOST_CHECK_EQUAL(random_reachability(seed, final_state, [&check_trace](auto& instance){
+            return check_trace(instance, Solver::post_star_accepts_fused(instance)); }), expected);
+        // The fused mode does not build the product automaton.
+        auto product_size = [](const auto& instance) {
+            size_t n_edges = 0;
+            for (const auto& state : instance.product_automaton().states()) {
+                n_edges += state->_edges.size();
+            }
+            return std::make_pair(instance.product_automaton().states().size() - instance.pda().states().size(), n_edges);
+        };
+        random_reachability(seed, final_state, [&product_size](auto& instance){
+            Solver::pre_star_accepts_fused(instance);
+            BOOST_CHECK(product_size(instance) == std::make_pair(size_t(0), size_t(0)));
+            return true; });
+        random_reachability(seed, final_state, [&product_size](auto& instance){
+            Solver::post_star_accepts_fused(instance);
+            BOOST_CHECK(product_size(instance) == std::make_pair(size_t(0), size_t(0)));
+            return true; });
+        if (expected) {
+            random_reachability(seed, final_state, [&product_size](auto& instance){
+                Solver::pre_star_accepts(instance);
+                BOOST_CHECK_GT(product_size(instance).second, 0);
+                return true; });
+        }
+    }
+    BOOST_CHECK_GT(n_accepted, 0);
+    BOOST_CHECK_LT(n_accepted, 20);
+}
@@ -28,6 +28,8 @@
 
 #include <boost/test/unit_test.hpp>
 #include <pdaaal/Weight.h>
+#include <random>
+#include <utility>
 
 using namespace pdaaal;
 
@@ -83,4 +85,66 @@ BOOST_AUTO_TEST_CASE(WeightFunctionCombinators) {
     auto result = d("Hello", 3);
     std::vector<long int> expected{5-3, 5*1, (5-3)*2+5*1*4};
     BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), expected.begin(), expected.end());
-}
\ No newline at end of file
+}
+
+template <typename Inner, std::size_t N>
+void check_array_kernels(std::mt19937& gen) {
+    using W = std::array<Inner, N>;
+    std::uniform_int_distribution<int> dist(0, 3); // Small range, so equal prefixes are common.
+    for (size_t k = 0; k < 200; ++k) {
+        W a{}, b{};
+        for (size_t i = 0; i < N; ++i) {
+            a[i] = static_cast<Inner>(dist(gen));
+            b[i] = static_cast<Inner>(dist(gen));
+        }
+        auto sum = add<W>()(a, b);
+        for (size_t i = 0; i < N; ++i) {
+            BOOST_CHECK_EQUAL(sum[i], a[i] + b[i]);
+        }
+        BOOST_CHECK_EQUAL(weight_less<W>()(a, b), std::less<W>()(a, b));
+        BOOST_CHECK_EQUAL(weight_less<W>()(b, a), std::less<W>()(b, a));
+        BOOST_CHECK(!weight_less<W>()(a, a));
+    }
+    W large{};
+    large.fill(max<Inner>()());
+    W small = large;
+    small[N - 1] = zero<Inner>()(); // Only the last element differs, and the unsigned values do not fit in signed lanes.
+    BOOST_CHECK(weight_less<W>()(small, large));
+    BOOST_CHECK(!weight_less<W>()(large, small));
+}
+
+template <typename Inner, std::size_t... Ns>
+void check_array_kernels_sizes(std::mt19937& gen, std::index_sequence<Ns...>) {
+    (check_array_kernels<Inner, Ns + 1>(gen), ...);
+}
+
+BOOST_AUTO_TEST_CASE(ArrayWeightKernels) {
+    std::mt19937 gen(42);
+    check_array_kernels_sizes<uint32_t>(gen, std::make_index_sequence<8>{});
+    check_array_kernels_sizes<uint64_t>(gen, std::make_index_sequence<8>{});
+    check_array_kernels_sizes<double>(gen, std::make_index_sequence<8>{});
+    check_array_kernels_sizes<int>(gen, std::make_index_sequence<3>{}); // No kernel. Uses the scalar fallback.
+}
+
+BOOST_AUTO_TEST_CASE(ArrayWeightLessNaN) {
+    using W = std::array<double, 4>;
+    auto nan = std::numeric_limits<double>::quiet_NaN();
+    W a{nan, 1, 2, 3};
+    W b{0, 1, 2, 4};
+    // NaN is neither less nor greater than 0, so the compare continues to the next elements, like std::less.
+    BOOST_CHECK_EQUAL(weight_less<W>()(a, b), std::less<W>()(a, b));
+    BOOST_CHECK_EQUAL(weight_less<W>()(b, a), std::less<W>()(b, a));
+}
+
+BOOST_AUTO_TEST_CASE(ArrayWeightConstexpr) {
+    using W = std::array<uint32_t, 4>;
+    constexpr W sum = add<W>()(W{1, 2, 3, 4}, W{4, 3, 2, 1});
+    static_assert(sum[0] == 5 && sum[3] == 5);
+    static_assert(weight_less<W>()(W{1, 2, 3, 4}, W{1, 2, 3, 5}));
+}
+
+BOOST_AUTO_TEST_CASE(ArrayWeightDefaultComparator) {
+    using W = std::array<uint32_t, 4>;
+    static_assert(std::is_same_v<weight_compare_t<W, std::less<W>>, weight_less<W>>);
+    static_assert(std::is_same_v<weight_compare_t<W, std::greater<W>>, std::greater<W>>);
+}
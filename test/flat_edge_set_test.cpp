@@ -0,0 +1,101 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   flat_edge_set_test.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#define BOOST_TEST_MODULE flat_edge_set
+
+#include <pdaaal/flat_edge_set.h>
+#include <boost/test/unit_test.hpp>
+#include <set>
+#include <tuple>
+
+using namespace pdaaal::details;
+
+BOOST_AUTO_TEST_CASE(FlatEdgeSetEmplace)
+{
+    flat_edge_set set;
+    BOOST_CHECK(set.empty());
+    BOOST_CHECK(!set.contains(4, 7, 10));
+
+    BOOST_CHECK(set.emplace(4, 7, 10));
+    BOOST_CHECK(set.emplace(4, 6, 10));
+    BOOST_CHECK(set.emplace(10, 7, 4));
+    BOOST_CHECK(!set.emplace(4, 7, 10));
+    BOOST_CHECK(set.emplace(4, std::numeric_limits<uint32_t>::max(), 10)); // epsilon label
+    BOOST_CHECK_EQUAL(set.size(), 4);
+
+    BOOST_CHECK(set.contains(4, 7, 10));
+    BOOST_CHECK(set.contains(10, 7, 4));
+    BOOST_CHECK(!set.contains(7, 4, 10));
+}
+
+BOOST_AUTO_TEST_CASE(FlatEdgeSetRehash)
+{
+    flat_edge_set set(10);
+    std::set<std::tuple<size_t,uint32_t,size_t>> reference;
+    for (size_t from = 0; from < 50; ++from) {
+        for (uint32_t label = 0; label < 20; ++label) {
+            size_t to = (from * 31 + label * 7) % 37;
+            BOOST_CHECK_EQUAL(set.emplace(from, label, to), reference.emplace(from, label, to).second);
+            BOOST_CHECK(!set.emplace(from, label, to));
+        }
+    }
+    BOOST_CHECK_EQUAL(set.size(), reference.size());
+    for (const auto& [from, label, to] : reference) {
+        BOOST_CHECK(set.contains(from, label, to));
+        BOOST_CHECK(!set.contains(from, label, to + 37));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FlatEdgeSetErase)
+{
+    flat_edge_set set;
+    std::set<std::tuple<size_t,uint32_t,size_t>> reference;
+    for (size_t from = 0; from < 30; ++from) {
+        for (uint32_t label = 0; label < 10; ++label) {
+            size_t to = (from * 13 + label * 5) % 17;
+            set.emplace(from, label, to);
+            reference.emplace(from, label, to);
+        }
+    }
+    BOOST_CHECK(!set.erase(100, 0, 0));
+    for (size_t from = 0; from < 30; from += 2) { // Erase every other from state.
+        for (uint32_t label = 0; label < 10; ++label) {
+            size_t to = (from * 13 + label * 5) % 17;
+            BOOST_CHECK(set.erase(from, label, to));
+            BOOST_CHECK(!set.erase(from, label, to));
+            reference.erase(std::make_tuple(from, label, to));
+        }
+    }
+    BOOST_CHECK_EQUAL(set.size(), reference.size());
+    for (size_t from = 0; from < 30; ++from) {
+        for (uint32_t label = 0; label < 10; ++label) {
+            size_t to = (from * 13 + label * 5) % 17;
+            BOOST_CHECK_EQUAL(set.contains(from, label, to), from % 2 == 1);
+        }
+    }
+    BOOST_CHECK(set.emplace(0, 0, 0)); // Erased elements can be added again.
+    BOOST_CHECK(set.contains(0, 0, 0));
+}
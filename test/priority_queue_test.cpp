@@ -0,0 +1,157 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   priority_queue_test.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+#define BOOST_TEST_MODULE priority_queue
+
+#include <pdaaal/priority_queue.h>
+#include <boost/test/unit_test.hpp>
+#include <array>
+#include <map>
+#include <random>
+
+using namespace pdaaal;
+
+// Pushes random weights (including improvements of existing keys) and checks that the queue pops the current best weight of
+// every key in non-decreasing order. Outdated elements popped from a lazy queue are skipped, like in post*.
+template <template<typename,typename,typename,typename,typename> class Queue>
+void check_queue(unsigned int seed) {
+    Queue<int,std::less<int>,size_t,size_t,std::hash<size_t>> queue;
+    std::map<size_t,int> best;
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<size_t> key_dist(0, 50);
+    std::uniform_int_distribution<int> weight_dist(0, 100);
+    for (size_t i = 0; i < 500; ++i) {
+        auto key = key_dist(gen);
+        auto weight = weight_dist(gen);
+        auto it = best.find(key);
+        if (it == best.end() || weight < it->second) {
+            best[key] = weight;
+            queue.push(weight, key, i);
+        }
+    }
+    int last = 0;
+    size_t popped = 0;
+    while (!queue.empty()) {
+        auto [weight, key, value] = queue.pop();
+        BOOST_CHECK_LE(last, weight);
+        last = weight;
+        if (weight != best[key]) continue; // Outdated
+        ++popped;
+        best[key] = -1; // Each key is current only once.
+    }
+    for (const auto& [key, weight] : best) {
+        BOOST_CHECK_EQUAL(weight, -1);
+    }
+    BOOST_CHECK_EQUAL(popped, best.size());
+}
+
+BOOST_AUTO_TEST_CASE(BinaryHeapQueue)
+{
+    for (unsigned int seed = 0; seed < 5; ++seed) {
+        check_queue<binary_heap_queue>(seed);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(AddressableHeapQueue)
+{
+    for (unsigned int seed = 0; seed < 5; ++seed) {
+        check_queue<addressable_heap_queue>(seed);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BucketQueue)
+{
+    for (unsigned int seed = 0; seed < 5; ++seed) {
+        check_queue<bucket_queue>(seed);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(AddressableHeapDecreaseKey)
+{
+    addressable_heap_queue<int,std::less<int>,char,int,std::hash<char>> queue;
+    queue.push(5, 'a', 1);
+    queue.push(3, 'b', 2);
+    queue.push(1, 'a', 3); // Decrease key, and update value.
+    queue.push(4, 'b', 4); // Not an improvement. Ignored.
+    BOOST_CHECK_EQUAL(queue.size(), 2);
+    auto [w1, k1, v1] = queue.pop();
+    BOOST_CHECK_EQUAL(w1, 1);
+    BOOST_CHECK_EQUAL(k1, 'a');
+    BOOST_CHECK_EQUAL(v1, 3);
+    auto [w2, k2, v2] = queue.pop();
+    BOOST_CHECK_EQUAL(w2, 3);
+    BOOST_CHECK_EQUAL(k2, 'b');
+    BOOST_CHECK_EQUAL(v2, 2);
+    BOOST_CHECK(queue.empty());
+    queue.push(7, 'a', 5); // A popped key can be pushed again.
+    BOOST_CHECK_EQUAL(std::get<0>(queue.pop()), 7);
+}
+
+BOOST_AUTO_TEST_CASE(AddressableHeapLexicographic)
+{
+    using W = std::array<int,2>;
+    addressable_heap_queue<W,std::less<W>,int,int,std::hash<int>> queue;
+    queue.push(W{1, 5}, 0, 0);
+    queue.push(W{0, 9}, 1, 0);
+    queue.push(W{1, 2}, 2, 0);
+    queue.push(W{1, 1}, 0, 0);
+    BOOST_CHECK_EQUAL(std::get<1>(queue.pop()), 1);
+    BOOST_CHECK_EQUAL(std::get<1>(queue.pop()), 0);
+    BOOST_CHECK_EQUAL(std::get<1>(queue.pop()), 2);
+    BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE(BucketQueueBelowMinimum)
+{
+    bucket_queue<unsigned int,std::less<unsigned int>,int,int,std::hash<int>> queue;
+    queue.push(10, 0, 0);
+    queue.push(12, 1, 0);
+    BOOST_CHECK_EQUAL(std::get<1>(queue.pop()), 0);
+    queue.push(4, 2, 0); // Below the current minimum.
+    BOOST_CHECK_EQUAL(std::get<0>(queue.pop()), 4);
+    BOOST_CHECK_EQUAL(std::get<0>(queue.pop()), 12);
+    BOOST_CHECK(queue.empty());
+}
+
+// A sliding range of weights wraps around the ring of buckets many times, and a weight below the minimum makes the range grow.
+BOOST_AUTO_TEST_CASE(BucketQueueSlidingRange)
+{
+    bucket_queue<unsigned int,std::less<unsigned int>,int,int,std::hash<int>> queue;
+    for (unsigned int w = 0; w < 4; ++w) {
+        queue.push(w, 0, 0);
+    }
+    for (unsigned int w = 0; w < 1000; ++w) {
+        BOOST_REQUIRE_EQUAL(std::get<0>(queue.pop()), w);
+        queue.push(w + 4, 0, 0);
+    }
+    BOOST_CHECK_EQUAL(queue.size(), 4);
+    queue.push(10, 1, 0); // Far below the minimum.
+    BOOST_CHECK_EQUAL(std::get<0>(queue.pop()), 10);
+    for (unsigned int w = 1000; w < 1004; ++w) {
+        BOOST_CHECK_EQUAL(std::get<0>(queue.pop()), w);
+    }
+    BOOST_CHECK(queue.empty());
+}
@@ -0,0 +1,99 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Copyright agent
+ */
+
+/*
+ * File:   workset_test.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on 16-10-2026.
+ */
+
+
+#define BOOST_TEST_MODULE workset
+
+#include <pdaaal/workset.h>
+#include <boost/test/unit_test.hpp>
+#include <deque>
+#include <random>
+
+using namespace pdaaal;
+
+struct edge_t {
+    size_t _from;
+    uint32_t _label;
+    size_t _to;
+};
+
+BOOST_AUTO_TEST_CASE(LifoAndFifoOrder)
+{
+    lifo_workset<edge_t> lifo;
+    fifo_workset<edge_t> fifo;
+    for (size_t i = 0; i < 5; ++i) {
+        lifo.push(edge_t{i, 0, i});
+        fifo.push(edge_t{i, 0, i});
+    }
+    BOOST_CHECK_EQUAL(lifo.size(), 5);
+    BOOST_CHECK_EQUAL(fifo.size(), 5);
+    for (size_t i = 0; i < 5; ++i) {
+        BOOST_CHECK_EQUAL(lifo.pop()._from, 4 - i);
+        BOOST_CHECK_EQUAL(fifo.pop()._from, i);
+    }
+    BOOST_CHECK(lifo.empty());
+    BOOST_CHECK(fifo.empty());
+}
+
+// Interleaves pushes and pops so the ring wraps around while it grows, and compares with a std::deque.
+BOOST_AUTO_TEST_CASE(RingMatchesDeque)
+{
+    ring_workset<edge_t> ring;
+    std::deque<size_t> expected;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> op_dist(0, 2);
+    size_t next = 0;
+    for (size_t i = 0; i < 20000; ++i) {
+        if (op_dist(gen) != 0 || expected.empty()) { // Push twice as often as pop, so the ring grows.
+            ring.push(edge_t{next, 0, 0});
+            expected.push_back(next++);
+        } else {
+            BOOST_REQUIRE_EQUAL(ring.pop()._from, expected.front());
+            expected.pop_front();
+        }
+        BOOST_REQUIRE_EQUAL(ring.size(), expected.size());
+    }
+    while (!expected.empty()) {
+        BOOST_REQUIRE_EQUAL(ring.pop()._from, expected.front());
+        expected.pop_front();
+    }
+    BOOST_CHECK(ring.empty());
+}
+
+BOOST_AUTO_TEST_CASE(HeuristicOrder)
+{
+    auto heuristic = [](size_t from, uint32_t label, size_t to) -> size_t { return from % 3; };
+    heuristic_workset<edge_t, decltype(heuristic)> workset(heuristic);
+    for (size_t i = 0; i < 9; ++i) {
+        workset.push(edge_t{i, 0, 0});
+    }
+    size_t last = 0;
+    while (!workset.empty()) {
+        auto h = workset.pop()._from % 3;
+        BOOST_CHECK_LE(last, h);
+        last = h;
+    }
+}